@@ -0,0 +1,180 @@
+#include "canvasindex.h"
+#include <QDebug>
+#include <opencv2/imgproc.hpp>
+
+const int CanvasIndex::SCALE;
+const int CanvasIndex::MIN_COARSE_ROWS;
+
+void CanvasIndex::reset()
+{
+    m_below.release();
+    m_above.release();
+    m_origin = 0;
+}
+
+cv::Mat CanvasIndex::narrow(const cv::Mat& grayRows) const
+{
+    cv::Mat result;
+    cv::resize(grayRows, result, cv::Size(qMax(1, grayRows.cols / SCALE), grayRows.rows), 0, 0, cv::INTER_AREA);
+    return result;
+}
+
+void CanvasIndex::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = qMax<qint64>(0, bytes);
+}
+
+// 丢弃最上面的 rows 行：先从倒序存放的 m_above 末尾删除，不够时再截掉 m_below 的开头
+void CanvasIndex::trimTop(int rows)
+{
+    const int fromAbove = qMin(rows, m_above.rows);
+    if (fromAbove > 0) {
+        m_above.pop_back(fromAbove);
+    }
+    const int fromBelow = qMin(rows - fromAbove, m_below.rows);
+    if (fromBelow > 0) {
+        m_below = m_below.rowRange(fromBelow, m_below.rows).clone();
+        m_origin += fromBelow;
+    }
+}
+
+// 丢弃最下面的 rows 行：先从 m_below 末尾删除，不够时再截掉 m_above 的开头（紧邻 m_origin 的行）
+void CanvasIndex::trimBottom(int rows)
+{
+    const int fromBelow = qMin(rows, m_below.rows);
+    if (fromBelow > 0) {
+        m_below.pop_back(fromBelow);
+    }
+    const int fromAbove = qMin(rows - fromBelow, m_above.rows);
+    if (fromAbove > 0) {
+        m_above = m_above.rowRange(fromAbove, m_above.rows).clone();
+        m_origin -= fromAbove;
+    }
+}
+
+// 超出预算时丢弃远离最近追加一端的行；一次裁到预算的 3/4，截断 Mat 开头的拷贝因此是均摊 O(1)
+void CanvasIndex::enforceBudget(bool keepBottom)
+{
+    const int width = m_below.empty() ? m_above.cols : m_below.cols;
+    if (m_memoryBudget <= 0 || width <= 0) {
+        return;
+    }
+    const qint64 maxRows = qMax<qint64>(1, m_memoryBudget / width);
+    const int rows = bottom() - top();
+    if (rows <= maxRows) {
+        return;
+    }
+    const int excess = rows - static_cast<int>(maxRows * 3 / 4);
+    if (keepBottom) {
+        trimTop(excess);
+    } else {
+        trimBottom(excess);
+    }
+}
+
+bool CanvasIndex::addRows(int logicalTop, const cv::Mat& grayRows)
+{
+    if (grayRows.empty() || grayRows.type() != CV_8UC1) {
+        return false;
+    }
+
+    const cv::Mat rows = narrow(grayRows);
+    if (isEmpty()) {
+        m_origin = logicalTop;
+        m_below = rows.clone();
+        return true;
+    }
+    const int width = m_below.empty() ? m_above.cols : m_below.cols;
+    if (rows.cols != width) {
+        return false;
+    }
+
+    if (logicalTop == bottom()) {
+        m_below.push_back(rows);
+        enforceBudget(true);
+        return true;
+    }
+    if (logicalTop + rows.rows == top()) {
+        cv::Mat reversed;
+        cv::flip(rows, reversed, 0);
+        m_above.push_back(reversed);
+        enforceBudget(false);
+        return true;
+    }
+    if (m_memoryBudget > 0) {
+        // 远端的行已按预算丢弃，长图又从这一端增长：以新行重新开始索引
+        m_above.release();
+        m_origin = logicalTop;
+        m_below = rows.clone();
+        return true;
+    }
+    qDebug() << "长图索引: 新行" << logicalTop << "与已有范围" << top() << "~" << bottom() << "不相接，忽略";
+    return false;
+}
+
+bool CanvasIndex::locate(const cv::Mat& grayRows, int& logicalY, double& score, double& margin) const
+{
+    score = 0.0;
+    margin = 0.0;
+    if (isEmpty() || grayRows.empty() || grayRows.rows / SCALE < MIN_COARSE_ROWS) {
+        return false;
+    }
+
+    // 拼出连续的索引图（只在定位时做一次）
+    cv::Mat canvas;
+    if (m_above.empty()) {
+        canvas = m_below;
+    } else {
+        cv::flip(m_above, canvas, 0);
+        if (!m_below.empty()) {
+            cv::vconcat(canvas, m_below, canvas);
+        }
+    }
+    const cv::Mat tmpl = narrow(grayRows);
+    if (tmpl.rows > canvas.rows || tmpl.cols != canvas.cols) {
+        return false;
+    }
+
+    // 粗匹配：高度再缩小 SCALE 倍，在整张长图上搜索
+    cv::Mat coarseCanvas;
+    cv::Mat coarseTmpl;
+    cv::resize(canvas, coarseCanvas, cv::Size(canvas.cols, qMax(1, canvas.rows / SCALE)), 0, 0, cv::INTER_AREA);
+    cv::resize(tmpl, coarseTmpl, cv::Size(tmpl.cols, tmpl.rows / SCALE), 0, 0, cv::INTER_AREA);
+    if (coarseTmpl.rows > coarseCanvas.rows) {
+        return false;
+    }
+    cv::Mat result;
+    cv::matchTemplate(coarseCanvas, coarseTmpl, result, cv::TM_CCOEFF_NORMED);
+    double coarseScore = 0.0;
+    cv::Point coarseLoc;
+    cv::minMaxLoc(result, nullptr, &coarseScore, nullptr, &coarseLoc);
+
+    // 次高峰：排除最高峰上下各一个模板高度（与最高峰重叠的位置）后的最大得分
+    double secondScore = -1.0;
+    const int excludeTop = qMax(0, coarseLoc.y - coarseTmpl.rows);
+    const int excludeBottom = qMin(result.rows, coarseLoc.y + coarseTmpl.rows + 1);
+    double rangeMax = 0.0;
+    if (excludeTop > 0) {
+        cv::minMaxLoc(result.rowRange(0, excludeTop), nullptr, &rangeMax);
+        secondScore = qMax(secondScore, rangeMax);
+    }
+    if (excludeBottom < result.rows) {
+        cv::minMaxLoc(result.rowRange(excludeBottom, result.rows), nullptr, &rangeMax);
+        secondScore = qMax(secondScore, rangeMax);
+    }
+    margin = coarseScore - secondScore;
+
+    // 精对齐：在粗位置上下 2*SCALE 行内按全分辨率行匹配
+    const int fineMargin = 2 * SCALE;
+    const int bandTop = qMax(0, coarseLoc.y * SCALE - fineMargin);
+    const int bandBottom = qMin(canvas.rows, coarseLoc.y * SCALE + tmpl.rows + fineMargin);
+    if (bandBottom - bandTop < tmpl.rows) {
+        return false;
+    }
+    cv::matchTemplate(canvas.rowRange(bandTop, bandBottom), tmpl, result, cv::TM_CCOEFF_NORMED);
+    cv::Point fineLoc;
+    cv::minMaxLoc(result, nullptr, &score, nullptr, &fineLoc);
+
+    logicalY = top() + bandTop + fineLoc.y;
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef CANVASINDEX_H
+#define CANVASINDEX_H
+
+#include <opencv2/core.hpp>
+
+// 整张长图的缩小灰度索引，用于跟丢后的重新定位。
+// 每次向长图追加新行时同步加入（宽度缩小 SCALE 倍，高度保留全分辨率），内存约为长图 RGBA 的 1/16；
+// 定位时先在高度也缩小 SCALE 倍的索引上做全图模板匹配，再在粗位置附近按全分辨率行精确对齐。
+// 长图可以向上、向下两个方向增长：向下的行顺序追加，向上的行倒序追加，都是均摊 O(1)。
+// 设置内存预算后只保留最近追加一端的若干行：重新定位针对的是快速甩动，目标总在当前位置附近，
+// 远端的行超出预算时丢弃，常驻内存因此与截图长度无关。
+class CanvasIndex
+{
+public:
+    // 清空索引（保留内存预算）
+    void reset();
+    // 索引的内存预算（字节），0 表示不限制
+    void setMemoryBudget(qint64 bytes);
+    // 加入长图新覆盖的行（CV_8UC1 灰度，全分辨率）；logicalTop 必须紧接当前范围的顶部或底部。
+    // 有预算时远端的行可能已被丢弃，不相接的新行（长图从被丢弃的一端继续增长）作为新的索引起点
+    bool addRows(int logicalTop, const cv::Mat& grayRows);
+
+    bool isEmpty() const { return m_below.empty() && m_above.empty(); }
+    int top() const { return m_origin - m_above.rows; }
+    int bottom() const { return m_origin + m_below.rows; }
+
+    // 在整张长图中查找 grayRows（全分辨率灰度）的位置，成功时返回其第 0 行对应的逻辑 Y 与匹配得分；
+    // margin 为粗匹配最高峰比上下各一个模板高度以外的次高峰高出的得分，重复的内容（列表项、表格行）会使它接近 0
+    bool locate(const cv::Mat& grayRows, int& logicalY, double& score, double& margin) const;
+
+    static const int SCALE = 4;             // 索引宽度（以及粗匹配高度）的缩小倍数
+    static const int MIN_COARSE_ROWS = 8;   // 粗匹配时模板至少保留的行数
+
+private:
+    cv::Mat narrow(const cv::Mat& grayRows) const;
+    void trimTop(int rows);
+    void trimBottom(int rows);
+    void enforceBudget(bool keepBottom);
+
+    cv::Mat m_below;    // 逻辑 Y >= m_origin 的行，按从上到下顺序
+    cv::Mat m_above;    // 逻辑 Y < m_origin 的行，按从下到上（倒序）存放
+    int m_origin = 0;
+    qint64 m_memoryBudget = 0;
+};
+
+#endif // CANVASINDEX_H
@@ -0,0 +1,132 @@
+#include "capturebackend.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QPixmap>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QDebug>
+#include <cmath>
+
+#ifdef RABBITSHOT_HAVE_XCB_SHM
+#include "x11shmcapturebackend.h"
+#endif
+
+bool CaptureBackend::prepare(QScreen* screen, const QRect& logicalRect)
+{
+    m_screen = screen;
+    m_logicalRect = logicalRect;
+    m_deviceRect = toDeviceRect(screen, logicalRect);
+    return m_screen != nullptr && !m_deviceRect.isEmpty();
+}
+
+QImage CaptureBackend::grab()
+{
+    if (m_logicalRect.isEmpty()) {
+        return QImage();
+    }
+
+    m_frameTimestampMs = QDateTime::currentMSecsSinceEpoch();
+    QElapsedTimer timer;
+    timer.start();
+    QImage frame = grabFrame();
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    if (frame.isNull()) {
+        m_stats.failCount++;
+        return frame;
+    }
+
+    m_stats.grabCount++;
+    m_stats.lastGrabNs = elapsed;
+    m_stats.totalGrabNs += elapsed;
+    m_stats.minGrabNs = (m_stats.grabCount == 1) ? elapsed : qMin(m_stats.minGrabNs, elapsed);
+    m_stats.maxGrabNs = qMax(m_stats.maxGrabNs, elapsed);
+    m_stats.totalBytes += frame.sizeInBytes();
+    return frame;
+}
+
+QScreen* CaptureBackend::screenForRect(const QRect& logicalRect)
+{
+    QScreen* best = nullptr;
+    qint64 bestArea = 0;
+    const QList<QScreen*> screens = QGuiApplication::screens();
+    for (QScreen* screen : screens) {
+        const QRect intersection = screen->geometry().intersected(logicalRect);
+        const qint64 area = qint64(intersection.width()) * intersection.height();
+        if (area > bestArea) {
+            bestArea = area;
+            best = screen;
+        }
+    }
+    return best ? best : QGuiApplication::primaryScreen();
+}
+
+QRect CaptureBackend::toDeviceRect(QScreen* screen, const QRect& logicalRect)
+{
+    if (!screen || logicalRect.isEmpty()) {
+        return QRect();
+    }
+    const QRect screenGeometry = screen->geometry();
+    const qreal dpr = screen->devicePixelRatio();
+    const QRect local = logicalRect.intersected(screenGeometry).translated(-screenGeometry.topLeft());
+    if (local.isEmpty()) {
+        return QRect();
+    }
+    // 屏幕左上角在逻辑/设备坐标中相同，只有屏幕内部的偏移和尺寸需要按 DPR 缩放
+    return QRect(screenGeometry.x() + static_cast<int>(std::floor(local.x() * dpr)),
+                 screenGeometry.y() + static_cast<int>(std::floor(local.y() * dpr)),
+                 static_cast<int>(std::floor(local.width() * dpr)),
+                 static_cast<int>(std::floor(local.height() * dpr)));
+}
+
+CaptureBackend* CaptureBackend::create(const QString& name)
+{
+    const QString key = name.trimmed().toLower();
+    const bool isAuto = key.isEmpty() || key == QLatin1String("auto");
+
+#ifdef RABBITSHOT_HAVE_XCB_SHM
+    if (isAuto || key == QLatin1String("x11-shm")) {
+        X11ShmCaptureBackend* backend = new X11ShmCaptureBackend();
+        if (backend->isAvailable()) {
+            return backend;
+        }
+        delete backend;
+        if (!isAuto) {
+            qDebug() << "x11-shm 后端不可用，回退到 qt 后端";
+        }
+    }
+#endif
+
+    if (!isAuto && key != QLatin1String("qt") && key != QLatin1String("x11-shm")) {
+        qDebug() << "未知的截图后端:" << name << "，使用 qt 后端";
+    }
+    return new QtScreenCaptureBackend();
+}
+
+QStringList CaptureBackend::availableBackends()
+{
+    QStringList backends;
+#ifdef RABBITSHOT_HAVE_XCB_SHM
+    backends << QStringLiteral("x11-shm");
+#endif
+    backends << QStringLiteral("qt");
+    return backends;
+}
+
+QImage QtScreenCaptureBackend::grabFrame()
+{
+    if (!m_screen) {
+        return QImage();
+    }
+    // grabWindow(0, ...) 的坐标相对于屏幕左上角（逻辑像素），只抓取选区部分
+    const QRect local = m_logicalRect.intersected(m_screen->geometry())
+                            .translated(-m_screen->geometry().topLeft());
+    if (local.isEmpty()) {
+        return QImage();
+    }
+    QPixmap pixmap = m_screen->grabWindow(0, local.x(), local.y(), local.width(), local.height());
+    if (pixmap.isNull()) {
+        return QImage();
+    }
+    return pixmap.toImage();
+}
@@ -0,0 +1,91 @@
+#ifndef CAPTUREBACKEND_H
+#define CAPTUREBACKEND_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QStringList>
+
+class QScreen;
+
+// 单个后端的抓取耗时统计，用于横向比较不同后端
+struct CaptureStats {
+    int grabCount = 0;          // 成功抓取次数
+    int failCount = 0;          // 失败次数
+    qint64 lastGrabNs = 0;      // 最近一次耗时（纳秒）
+    qint64 totalGrabNs = 0;     // 累计耗时
+    qint64 minGrabNs = 0;       // 最短耗时
+    qint64 maxGrabNs = 0;       // 最长耗时
+    qint64 totalBytes = 0;      // 累计抓取的像素字节数
+
+    double averageGrabMs() const { return grabCount > 0 ? totalGrabNs / 1e6 / grabCount : 0.0; }
+};
+
+// 截图后端接口：只抓取选区对应的设备像素区域，而不是整屏抓取后再裁剪
+class CaptureBackend
+{
+public:
+    virtual ~CaptureBackend() = default;
+
+    virtual QString name() const = 0;
+
+    // 绑定目标屏幕与选区（全局逻辑坐标）。选区或屏幕变化时需要重新调用
+    virtual bool prepare(QScreen* screen, const QRect& logicalRect);
+
+    // 抓取一帧（设备像素），同时记录耗时
+    QImage grab();
+
+    // 是否为实时屏幕源（回放等离线源返回 false）
+    virtual bool isLive() const { return true; }
+    // grab() 能否在 GUI 线程以外调用；不能时截图不使用独立线程，由 GUI 线程的定时器抓取
+    virtual bool supportsThreadedGrab() const { return true; }
+    // 离线源是否已读完
+    virtual bool atEnd() const { return false; }
+    // 离线源按原始节奏回放时，距下一帧的间隔；-1 表示使用调用方自己的检测间隔
+    virtual int nextFrameDelayMs() const { return -1; }
+
+    QScreen* screen() const { return m_screen; }
+    QRect logicalRect() const { return m_logicalRect; }
+    QRect deviceRect() const { return m_deviceRect; }
+
+    // 最近一帧的时间戳（毫秒）：实时源为开始抓取的时刻，离线源为录制时的相对时间。
+    // 运动模型只使用帧间差值，回放因此与处理速度无关
+    qint64 frameTimestampMs() const { return m_frameTimestampMs; }
+
+    const CaptureStats& stats() const { return m_stats; }
+    void resetStats() { m_stats = CaptureStats(); }
+
+    // 选择与选区相交面积最大的屏幕（而不是总用主屏幕）
+    static QScreen* screenForRect(const QRect& logicalRect);
+    // 全局逻辑坐标 -> 全局设备像素坐标（屏幕原点在两个坐标系中保持一致）
+    static QRect toDeviceRect(QScreen* screen, const QRect& logicalRect);
+
+    // 后端工厂："auto" 或空字符串选择当前平台上最快的可用后端
+    static CaptureBackend* create(const QString& name = QString());
+    static QStringList availableBackends();
+
+protected:
+    virtual QImage grabFrame() = 0;
+
+    QScreen* m_screen = nullptr;
+    QRect m_logicalRect;
+    QRect m_deviceRect;
+    qint64 m_frameTimestampMs = 0;  // 离线源在 grabFrame 中改为记录的时间戳
+
+private:
+    CaptureStats m_stats;
+};
+
+// 基于 QScreen::grabWindow 的通用后端，只请求选区范围的像素
+class QtScreenCaptureBackend : public CaptureBackend
+{
+public:
+    QString name() const override { return QStringLiteral("qt"); }
+    // QScreen::grabWindow 与 QPixmap 只保证在 GUI 线程可用
+    bool supportsThreadedGrab() const override { return false; }
+
+protected:
+    QImage grabFrame() override;
+};
+
+#endif // CAPTUREBACKEND_H
@@ -0,0 +1,76 @@
+#include "capturescheduler.h"
+#include <cmath>
+
+const int CaptureScheduler::MIN_INTERVAL_MS;
+const int CaptureScheduler::IDLE_INTERVAL_MS;
+const int CaptureScheduler::IDLE_FRAMES;
+const int CaptureScheduler::BACKOFF_FRAMES;
+
+void CaptureScheduler::reset(int baseIntervalMs)
+{
+    m_interval = qBound(MIN_INTERVAL_MS, baseIntervalMs, IDLE_INTERVAL_MS);
+    m_stillFrames = 0;
+    m_unchangedFrames = 0;
+    m_backoffInterval = 0;
+    m_effectiveHeight = 0;
+}
+
+int CaptureScheduler::quietInterval() const
+{
+    if (m_effectiveHeight <= 0) {
+        return IDLE_INTERVAL_MS;
+    }
+    const int interval = static_cast<int>((1.0 - TARGET_OVERLAP) * m_effectiveHeight / TYPICAL_VELOCITY);
+    return qBound(MIN_INTERVAL_MS, interval, IDLE_INTERVAL_MS);
+}
+
+int CaptureScheduler::markUnchanged()
+{
+    // 不变的帧不经过匹配，在这里按静止计数，否则停下后永远进入不了慢速轮询
+    if (++m_stillFrames >= IDLE_FRAMES) {
+        m_interval = qMax(m_interval, quietInterval());
+    }
+    if (++m_unchangedFrames >= BACKOFF_FRAMES) {
+        const int current = interval();
+        m_backoffInterval = qMax(current, qMin(quietInterval(), current * 2));
+    }
+    return interval();
+}
+
+int CaptureScheduler::wake()
+{
+    m_unchangedFrames = 0;
+    m_backoffInterval = 0;
+    return m_interval;
+}
+
+int CaptureScheduler::markLost()
+{
+    wake();
+    m_stillFrames = 0;
+    m_interval = MIN_INTERVAL_MS;
+    return m_interval;
+}
+
+int CaptureScheduler::update(double velocityPxPerMs, int effectiveHeight)
+{
+    wake();
+    if (effectiveHeight > 0) {
+        m_effectiveHeight = effectiveHeight;
+    }
+    const double speed = std::abs(velocityPxPerMs);
+    if (speed < IDLE_VELOCITY || effectiveHeight <= 0) {
+        // 刚停下时先保持当前节奏，连续静止后才降为慢速轮询
+        if (++m_stillFrames >= IDLE_FRAMES) {
+            m_interval = quietInterval();
+        }
+        return m_interval;
+    }
+
+    // 两帧之间内容移动 (1 - 目标重叠) 个有效高度所需的时间
+    m_stillFrames = 0;
+    const double travel = (1.0 - TARGET_OVERLAP) * effectiveHeight;
+    const int interval = static_cast<int>(travel / speed);
+    m_interval = qBound(MIN_INTERVAL_MS, interval, IDLE_INTERVAL_MS);
+    return m_interval;
+}
@@ -0,0 +1,50 @@
+#ifndef CAPTURESCHEDULER_H
+#define CAPTURESCHEDULER_H
+
+#include <QtGlobal>
+
+// 截图调度：根据滚动速度安排下一次抓取的时间，使相邻两帧的重叠落在目标比例附近。
+// 滚动越快间隔越短（保证有重叠），越慢间隔越长（避免重复抓取），静止时退回慢速轮询；
+// 画面连续多帧完全不变时间隔再按指数退避，画面变化时立即恢复。
+// 慢速轮询和退避的间隔都不超过“按典型滚动速度移动 (1 - 目标重叠) 个有效高度”所需的时间，
+// 停顿后重新开始滚动时，第一帧仍能与上一帧重叠。
+class CaptureScheduler
+{
+public:
+    // 开始新的截图会话；速度未知前使用基础间隔
+    void reset(int baseIntervalMs);
+
+    // 用最新的速度（像素/毫秒）和有效高度更新，返回下一次抓取的间隔
+    int update(double velocityPxPerMs, int effectiveHeight);
+
+    // 画面与上一帧完全相同：计为一次静止，连续 BACKOFF_FRAMES 次后间隔每次加倍，返回新的间隔
+    int markUnchanged();
+    // 画面发生变化：结束退避，返回退避前的间隔
+    int wake();
+    // 画面变化但未能与上一帧匹配（滚动越过重叠区域，或慢速轮询后的第一帧）：立即回到最短间隔以尽快重新跟上
+    int markLost();
+
+    int interval() const { return m_backoffInterval > 0 ? m_backoffInterval : m_interval; }
+    bool isIdle() const { return m_stillFrames >= IDLE_FRAMES; }
+    bool isBackedOff() const { return m_backoffInterval > 0; }
+
+    static const int MIN_INTERVAL_MS = 16;      // 最短间隔（约 60 帧/秒）
+    static const int IDLE_INTERVAL_MS = 500;    // 静止轮询和退避的最长间隔，同时也是滚动时的最长间隔
+    static const int IDLE_FRAMES = 3;           // 连续多少次静止后进入慢速轮询
+    static const int BACKOFF_FRAMES = 3;        // 连续多少帧不变后开始退避
+    static constexpr double TARGET_OVERLAP = 0.4;   // 目标重叠比例（30%~50% 之间）
+    static constexpr double IDLE_VELOCITY = 0.01;   // 低于此速度视为静止（像素/毫秒，即 10 像素/秒）
+    static constexpr double TYPICAL_VELOCITY = 2.0; // 停顿后重新滚动的典型速度（像素/毫秒，即 2000 像素/秒）
+
+private:
+    // 静止或退避时允许的最长间隔，由最近的有效高度决定
+    int quietInterval() const;
+
+    int m_interval = 200;
+    int m_stillFrames = 0;
+    int m_unchangedFrames = 0;
+    int m_backoffInterval = 0;  // 0 表示未退避
+    int m_effectiveHeight = 0;  // 最近一次匹配的有效高度，0 表示未知
+};
+
+#endif // CAPTURESCHEDULER_H
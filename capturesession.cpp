@@ -0,0 +1,275 @@
+#include "capturesession.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+
+bool CaptureSessionFormat::isContainerPath(const QString& path)
+{
+    QFileInfo info(path);
+    if (info.isDir()) {
+        return false;
+    }
+    return info.suffix().compare(QLatin1String(CONTAINER_SUFFIX), Qt::CaseInsensitive) == 0;
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    close();
+}
+
+bool SessionRecorder::open(const QString& path)
+{
+    close();
+    m_path = path;
+    m_container = CaptureSessionFormat::isContainerPath(path);
+    m_frameCount = 0;
+
+    if (m_container) {
+        m_containerFile.setFileName(path);
+        if (!m_containerFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qDebug() << "❌ 无法创建录制文件:" << path;
+            return false;
+        }
+        m_stream.setDevice(&m_containerFile);
+        m_stream.setVersion(QDataStream::Qt_6_0);
+        m_stream << CaptureSessionFormat::CONTAINER_MAGIC << CaptureSessionFormat::CONTAINER_VERSION;
+    } else {
+        QDir dir(path);
+        if (!dir.exists() && !QDir().mkpath(path)) {
+            qDebug() << "❌ 无法创建录制目录:" << path;
+            return false;
+        }
+        m_indexFile.setFileName(dir.filePath(QLatin1String(CaptureSessionFormat::INDEX_FILE_NAME)));
+        if (!m_indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qDebug() << "❌ 无法创建录制索引:" << m_indexFile.fileName();
+            return false;
+        }
+        m_indexFile.write(CaptureSessionFormat::INDEX_HEADER);
+        m_indexFile.write("\n");
+    }
+
+    m_clock.start();
+    m_open = true;
+    qDebug() << "⏺ 开始录制会话:" << path;
+    return true;
+}
+
+void SessionRecorder::addFrame(const QImage& frame)
+{
+    if (!m_open || frame.isNull()) {
+        return;
+    }
+    const qint64 timestampMs = m_clock.elapsed();
+
+    if (m_container) {
+        m_stream << timestampMs << frame;
+    } else {
+        const QString fileName = QString("frame_%1.png").arg(m_frameCount, 6, 10, QChar('0'));
+        // PNG 质量 80：低压缩等级，尽量减少对截图循环的影响
+        if (!frame.save(QDir(m_path).filePath(fileName), "PNG", 80)) {
+            qDebug() << "❌ 写入录制帧失败:" << fileName;
+            return;
+        }
+        m_indexFile.write(QString("%1\t%2\n").arg(timestampMs).arg(fileName).toUtf8());
+    }
+    m_frameCount++;
+}
+
+void SessionRecorder::close()
+{
+    if (!m_open) {
+        return;
+    }
+    if (m_container) {
+        m_stream.setDevice(nullptr);
+        m_containerFile.close();
+    } else {
+        m_indexFile.close();
+    }
+    m_open = false;
+    qDebug() << "⏹ 会话录制结束:" << m_path << "帧数:" << m_frameCount;
+}
+
+SessionReplayBackend::~SessionReplayBackend()
+{
+    m_stream.setDevice(nullptr);
+    m_containerFile.close();
+}
+
+bool SessionReplayBackend::open(const QString& path)
+{
+    m_path = path;
+    m_container = CaptureSessionFormat::isContainerPath(path);
+    m_entries.clear();
+    m_position = 0;
+    m_frameCount = 0;
+    m_lastTimestampMs = -1;
+    m_hasPending = false;
+
+    if (m_container) {
+        m_containerFile.setFileName(path);
+        if (!m_containerFile.open(QIODevice::ReadOnly)) {
+            qDebug() << "❌ 无法打开回放文件:" << path;
+            return false;
+        }
+        m_stream.setDevice(&m_containerFile);
+        m_stream.setVersion(QDataStream::Qt_6_0);
+        quint32 magic = 0;
+        quint32 version = 0;
+        m_stream >> magic >> version;
+        if (magic != CaptureSessionFormat::CONTAINER_MAGIC || version > CaptureSessionFormat::CONTAINER_VERSION) {
+            qDebug() << "❌ 不是有效的 RabbitShot 录制文件:" << path;
+            return false;
+        }
+        if (!readNextContainerFrame()) {
+            qDebug() << "❌ 录制文件中没有帧:" << path;
+            return false;
+        }
+        m_frameSize = m_pendingFrame.size();
+        m_frameCount = countContainerFrames(path);
+    } else {
+        QFile index(QDir(path).filePath(QLatin1String(CaptureSessionFormat::INDEX_FILE_NAME)));
+        if (!index.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qDebug() << "❌ 无法打开回放索引:" << index.fileName();
+            return false;
+        }
+        QTextStream in(&index);
+        if (in.readLine().trimmed() != QLatin1String(CaptureSessionFormat::INDEX_HEADER)) {
+            qDebug() << "❌ 回放索引格式不正确:" << index.fileName();
+            return false;
+        }
+        while (!in.atEnd()) {
+            const QStringList fields = in.readLine().split('\t');
+            if (fields.size() != 2) {
+                continue;
+            }
+            m_entries.append({fields.at(0).toLongLong(), fields.at(1)});
+        }
+        if (m_entries.isEmpty()) {
+            qDebug() << "❌ 回放目录中没有帧:" << path;
+            return false;
+        }
+        m_frameCount = m_entries.size();
+        m_frameSize = QImage(QDir(path).filePath(m_entries.first().fileName)).size();
+    }
+
+    qDebug() << "▶️ 打开回放会话:" << path << (m_container ? "(单文件)" : "(目录)")
+             << "帧尺寸:" << m_frameSize;
+    return !m_frameSize.isEmpty();
+}
+
+bool SessionReplayBackend::prepare(QScreen* screen, const QRect& logicalRect)
+{
+    // 回放不依赖屏幕，只记录选区以满足基类的状态检查
+    m_screen = screen;
+    m_logicalRect = logicalRect;
+    m_deviceRect = QRect(QPoint(0, 0), m_frameSize);
+    return !m_frameSize.isEmpty();
+}
+
+bool SessionReplayBackend::atEnd() const
+{
+    return m_container ? !m_hasPending : m_position >= m_entries.size();
+}
+
+int SessionReplayBackend::nextFrameDelayMs() const
+{
+    if (atEnd()) {
+        return -1;
+    }
+    const qint64 next = m_container ? m_pendingTimestampMs : m_entries.at(m_position).timestampMs;
+    if (m_lastTimestampMs < 0) {
+        return 0;
+    }
+    return static_cast<int>(qMax<qint64>(0, next - m_lastTimestampMs));
+}
+
+bool SessionReplayBackend::readNextContainerFrame()
+{
+    m_hasPending = false;
+    if (m_stream.atEnd()) {
+        return false;
+    }
+    qint64 timestampMs = 0;
+    QImage frame;
+    m_stream >> timestampMs >> frame;
+    if (m_stream.status() != QDataStream::Ok || frame.isNull()) {
+        return false;
+    }
+    m_pendingTimestampMs = timestampMs;
+    m_pendingFrame = frame;
+    m_hasPending = true;
+    return true;
+}
+
+// 单文件模式预先统计帧数：只解析记录头并跳过 PNG 数据块，不解码图像。
+// 与 readNextContainerFrame 的结束条件一致：遇到文件末尾、空图像或损坏的记录即停止
+int SessionReplayBackend::countContainerFrames(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+
+    static const char pngSignature[8] = { char(0x89), 'P', 'N', 'G', '\r', '\n', char(0x1a), '\n' };
+    int frames = 0;
+    while (!stream.atEnd()) {
+        // 每条记录：[qint64 时间戳][qint32 非空标记][PNG 数据]（QImage 的 QDataStream 序列化格式）
+        qint64 timestampMs = 0;
+        qint32 notNull = 0;
+        stream >> timestampMs >> notNull;
+        if (stream.status() != QDataStream::Ok || notNull == 0 || file.read(8) != QByteArray(pngSignature, 8)) {
+            break;
+        }
+        bool complete = false;
+        for (;;) {
+            quint32 length = 0;
+            QByteArray type;
+            stream >> length;
+            type = file.read(4);
+            if (stream.status() != QDataStream::Ok || type.size() != 4 || !file.seek(file.pos() + qint64(length) + 4)) {
+                break;
+            }
+            if (type == "IEND") {
+                complete = file.pos() <= file.size();
+                break;
+            }
+        }
+        if (!complete) {
+            break;
+        }
+        frames++;
+    }
+    return frames;
+}
+
+QImage SessionReplayBackend::grabFrame()
+{
+    if (atEnd()) {
+        return QImage();
+    }
+
+    QImage frame;
+    if (m_container) {
+        frame = m_pendingFrame;
+        m_lastTimestampMs = m_pendingTimestampMs;
+        readNextContainerFrame();
+    } else {
+        const IndexEntry& entry = m_entries.at(m_position);
+        frame = QImage(QDir(m_path).filePath(entry.fileName));
+        m_lastTimestampMs = entry.timestampMs;
+    }
+    m_position++;
+    m_frameTimestampMs = m_lastTimestampMs;
+
+    if (frame.isNull()) {
+        qDebug() << "❌ 回放帧读取失败，序号:" << (m_position - 1);
+    }
+    return frame;
+}
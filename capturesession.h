@@ -0,0 +1,95 @@
+#ifndef CAPTURESESSION_H
+#define CAPTURESESSION_H
+
+#include "capturebackend.h"
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QList>
+
+// 录制会话格式（两种等价形式）：
+//   目录：session.idx 索引 + frame_000000.png ...
+//         索引首行 "RabbitShot-Session 1"，之后每行 "<相对毫秒时间戳>\t<帧文件名>"
+//   单文件（扩展名 .rsrec）：QDataStream，依次为 魔数、版本，然后重复 [qint64 时间戳][QImage]
+namespace CaptureSessionFormat {
+    const char* const INDEX_FILE_NAME = "session.idx";
+    const char* const INDEX_HEADER = "RabbitShot-Session 1";
+    const char* const CONTAINER_SUFFIX = "rsrec";
+    const quint32 CONTAINER_MAGIC = 0x52535231;  // "RSR1"
+    const quint32 CONTAINER_VERSION = 1;
+
+    bool isContainerPath(const QString& path);
+}
+
+// 录制器：把实时截图逐帧写成上述格式，便于离线复现与基准测试
+class SessionRecorder
+{
+public:
+    SessionRecorder() = default;
+    ~SessionRecorder();
+
+    bool open(const QString& path);
+    void addFrame(const QImage& frame);
+    void close();
+
+    bool isOpen() const { return m_open; }
+    int frameCount() const { return m_frameCount; }
+
+private:
+    QString m_path;
+    bool m_open = false;
+    bool m_container = false;
+    int m_frameCount = 0;
+    QElapsedTimer m_clock;
+    QFile m_indexFile;
+    QFile m_containerFile;
+    QDataStream m_stream;
+};
+
+// 回放后端：按顺序返回录制的帧，走与实时截图完全相同的检测/去重/拼接流程
+class SessionReplayBackend : public CaptureBackend
+{
+public:
+    SessionReplayBackend() = default;
+    ~SessionReplayBackend() override;
+
+    QString name() const override { return QStringLiteral("replay"); }
+    bool prepare(QScreen* screen, const QRect& logicalRect) override;
+    bool isLive() const override { return false; }
+    bool atEnd() const override;
+    int nextFrameDelayMs() const override;
+
+    bool open(const QString& path);
+    // 将要回放的总帧数（两种格式含义相同）
+    int frameCount() const { return m_frameCount; }
+    QSize frameSize() const { return m_frameSize; }
+
+protected:
+    QImage grabFrame() override;
+
+private:
+    struct IndexEntry {
+        qint64 timestampMs;
+        QString fileName;
+    };
+
+    bool readNextContainerFrame();
+    static int countContainerFrames(const QString& path);
+
+    QString m_path;
+    bool m_container = false;
+    QList<IndexEntry> m_entries;   // 目录模式的帧索引
+    int m_position = 0;            // 下一帧序号
+    int m_frameCount = 0;
+    qint64 m_lastTimestampMs = -1;
+    QSize m_frameSize;
+
+    // 单文件模式：预读一帧以便提前知道下一帧的时间戳
+    QFile m_containerFile;
+    QDataStream m_stream;
+    bool m_hasPending = false;
+    qint64 m_pendingTimestampMs = 0;
+    QImage m_pendingFrame;
+};
+
+#endif // CAPTURESESSION_H
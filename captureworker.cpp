@@ -0,0 +1,82 @@
+#include "captureworker.h"
+#include "screenshotcapture.h"
+#include <QDebug>
+
+CaptureWorker::CaptureWorker(FrameRing<CaptureTask>* ring, Grabber grabber, QObject* parent)
+    : QObject(parent)
+    , m_ring(ring)
+    , m_grabber(std::move(grabber))
+    , m_timer(new QTimer(this))
+{
+    // 定时器是子对象，随 moveToThread 一起进入截图线程
+    connect(m_timer, &QTimer::timeout, this, &CaptureWorker::grabOnce);
+}
+
+void CaptureWorker::requestGrab()
+{
+    QMetaObject::invokeMethod(this, &CaptureWorker::grabOnce, Qt::QueuedConnection);
+}
+
+void CaptureWorker::setInterval(int intervalMs)
+{
+    QMetaObject::invokeMethod(this, [this, intervalMs]() {
+        m_timer->setInterval(intervalMs);
+    }, Qt::QueuedConnection);
+}
+
+void CaptureWorker::acknowledgeFrames()
+{
+    m_notifyPending.store(false, std::memory_order_release);
+}
+
+void CaptureWorker::setFrameCallback(std::function<void()> callback)
+{
+    m_frameCallback = std::move(callback);
+}
+
+quint64 CaptureWorker::droppedFrames() const
+{
+    return m_ring->droppedCount();
+}
+
+void CaptureWorker::start(int intervalMs)
+{
+    m_running = true;
+    m_timer->start(intervalMs);
+}
+
+void CaptureWorker::stop()
+{
+    m_running = false;
+    m_timer->stop();
+}
+
+void CaptureWorker::grabOnce()
+{
+    if (!m_running) {
+        return;
+    }
+
+    qint64 timestampMs = 0;
+    QImage frame = m_grabber(timestampMs);
+    if (frame.isNull()) {
+        return;
+    }
+
+    CaptureTask task;
+    task.screenshot = frame;
+    task.timestamp = timestampMs;
+    task.taskId = m_nextTaskId++;
+
+    const int dropped = m_ring->pushDropOldest(std::move(task));
+    if (dropped > 0) {
+        qDebug() << "⚠️ 拼接处理落后，丢弃最旧帧" << dropped << "个，累计" << m_ring->droppedCount();
+    }
+
+    if (m_frameCallback) {
+        m_frameCallback();
+    }
+    if (!m_notifyPending.exchange(true, std::memory_order_acq_rel)) {
+        emit frameAvailable();
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef CAPTUREWORKER_H
+#define CAPTUREWORKER_H
+
+#include <QObject>
+#include <QImage>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+
+#include "framering.h"
+
+struct CaptureTask;
+
+// 截图生产者：运行在独立线程中，定时抓取选区并写入有界环形队列。
+// 消费者（拼接）落后时队列丢弃最旧的帧，保证 GUI 线程上永远不会执行抓屏。
+class CaptureWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 抓取一帧，并通过 timestampMs 返回该帧的时间戳（与串行路径相同，取自截图后端）
+    using Grabber = std::function<QImage(qint64& timestampMs)>;
+
+    CaptureWorker(FrameRing<CaptureTask>* ring, Grabber grabber, QObject* parent = nullptr);
+
+    // 以下接口可在任意线程调用
+    void requestGrab();                 // 立即抓取一帧（例如滚轮事件）
+    void setInterval(int intervalMs);
+    void acknowledgeFrames();           // 消费者开始取帧前调用，允许再次发出 frameAvailable
+    // 每写入一帧后在截图线程中直接回调（不合并），用于唤醒拼接流水线；需在 start 之前设置
+    void setFrameCallback(std::function<void()> callback);
+    quint64 droppedFrames() const;
+
+public slots:
+    void start(int intervalMs);
+    void stop();
+
+signals:
+    // 队列从空变为非空时发出（合并通知，避免事件堆积）
+    void frameAvailable();
+
+private slots:
+    void grabOnce();
+
+private:
+    FrameRing<CaptureTask>* m_ring;
+    Grabber m_grabber;
+    std::function<void()> m_frameCallback;
+    QTimer* m_timer;
+    bool m_running = false;
+    int m_nextTaskId = 0;
+    std::atomic<bool> m_notifyPending{false};
+};
+
+#endif // CAPTUREWORKER_H
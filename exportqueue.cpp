@@ -0,0 +1,158 @@
+#include "exportqueue.h"
+#include "pngstreamwriter.h"
+#include "stitchcanvas.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+
+ExportQueue::ExportQueue(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ExportQueue::~ExportQueue()
+{
+    // 退出时放弃未完成的导出（QSaveFile 不会留下写了一半的文件）
+    m_pending.clear();
+    m_cancelRequested.storeRelaxed(1);
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+int ExportQueue::enqueue(const QString& filePath, const QSharedPointer<StitchCanvas>& canvas, const QImage& fallbackImage)
+{
+    Job job;
+    job.id = m_nextJobId++;
+    job.filePath = filePath;
+    job.canvas = canvas;
+    job.fallbackImage = fallbackImage;
+    m_pending.append(job);
+    qDebug() << "📥 导出任务" << job.id << "加入队列:" << filePath << "排队" << m_pending.size();
+
+    if (!m_thread) {
+        startNextJob();
+    }
+    return job.id;
+}
+
+void ExportQueue::cancelAll()
+{
+    const QList<Job> pending = m_pending;
+    m_pending.clear();
+    for (const Job& job : pending) {
+        emit jobFinished(job.id, job.filePath, false, true, "导出已取消");
+    }
+    if (m_thread) {
+        m_cancelRequested.storeRelaxed(1);
+    }
+}
+
+bool ExportQueue::isBusy() const
+{
+    return m_thread != nullptr;
+}
+
+int ExportQueue::pendingCount() const
+{
+    return m_pending.size() + (m_thread ? 1 : 0);
+}
+
+void ExportQueue::startNextJob()
+{
+    if (m_thread || m_pending.isEmpty()) {
+        return;
+    }
+
+    m_current = m_pending.takeFirst();
+    m_cancelRequested.storeRelaxed(0);
+    m_currentSuccess = false;
+    m_currentCancelled = false;
+    m_currentError.clear();
+
+    const Job job = m_current;
+    m_thread = QThread::create([this, job]() {
+        m_currentSuccess = runJob(job, &m_currentError, &m_currentCancelled);
+    });
+    connect(m_thread, &QThread::finished, this, &ExportQueue::onJobThreadFinished);
+    emit jobStarted(job.id, job.filePath);
+    m_thread->start();
+}
+
+void ExportQueue::onJobThreadFinished()
+{
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    const Job job = m_current;
+    m_current = Job();  // 释放画布引用（若已开始新的截图，旧画布及其换出文件在这里释放）
+    emit jobFinished(job.id, job.filePath, m_currentSuccess, m_currentCancelled, m_currentError);
+    startNextJob();
+}
+
+// 在导出线程中执行
+bool ExportQueue::runJob(const Job& job, QString* errorMessage, bool* cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const bool hasCanvas = job.canvas && !job.canvas->isEmpty();
+
+    // 画布为空（只有基础图片）或非 PNG 格式时交给 Qt 编码器，需要完整图像
+    if (!hasCanvas || !job.filePath.endsWith(".png", Qt::CaseInsensitive)) {
+        emit progressChanged(job.id, 0);
+        const QImage image = hasCanvas ? job.canvas->image() : job.fallbackImage;
+        if (image.isNull()) {
+            *errorMessage = "没有可保存的截图";
+            return false;
+        }
+        if (!image.save(job.filePath)) {
+            *errorMessage = "图片编码失败";
+            return false;
+        }
+        emit progressChanged(job.id, 100);
+        qDebug() << "💾 导出完成:" << job.filePath << "尺寸:" << image.size() << "耗时:" << timer.elapsed() << "ms";
+        return true;
+    }
+
+    // 导出开始时的边界为准，截图进行中继续追加的内容不包含在本次导出中
+    const QRect bounds = job.canvas->bounds();
+    QSaveFile file(job.filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorMessage = file.errorString();
+        return false;
+    }
+
+    PngStreamWriter writer(&file);
+    int lastPercent = -1;
+    writer.setProgressCallback([&](int rowsWritten) {
+        const int percent = int(qint64(rowsWritten) * 100 / bounds.height());
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progressChanged(job.id, percent);
+        }
+        return m_cancelRequested.loadRelaxed() == 0;
+    });
+    // 按条带并行编码，各条带直接从画布读取自己的行
+    const QSharedPointer<StitchCanvas> canvas = job.canvas;
+    const bool ok = writer.writeImage(bounds.width(), bounds.height(), [canvas, bounds](int y, uchar* row) {
+        canvas->readRow(bounds.top() + y, bounds.left(), bounds.width(), row);
+    });
+    if (!ok) {
+        file.cancelWriting();
+        *cancelled = writer.isCancelled();
+        *errorMessage = *cancelled ? QString("导出已取消") : writer.errorString();
+        return false;
+    }
+    if (!file.commit()) {
+        *errorMessage = file.errorString();
+        return false;
+    }
+
+    qDebug() << "💾 流式导出 PNG:" << QFileInfo(job.filePath).fileName() << "尺寸:" << bounds.size()
+             << "耗时:" << timer.elapsed() << "ms";
+    return true;
+}
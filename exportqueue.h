@@ -0,0 +1,62 @@
+#ifndef EXPORTQUEUE_H
+#define EXPORTQUEUE_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QAtomicInt>
+
+class QThread;
+class StitchCanvas;
+
+// 后台导出队列：任务按提交顺序在独立线程中逐个执行（PNG 编码再由 PngStreamWriter 按条带并行），GUI 线程不被阻塞。
+// 任务持有画布的共享引用，导出期间可以开始新的截图；进度与结果通过信号回到 GUI 线程
+class ExportQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ExportQueue(QObject* parent = nullptr);
+    ~ExportQueue();
+
+    // 加入导出任务，返回任务编号。PNG 从画布流式编码；画布为空时写出 fallbackImage，其他格式先合成整张图像
+    int enqueue(const QString& filePath, const QSharedPointer<StitchCanvas>& canvas, const QImage& fallbackImage = QImage());
+    // 取消正在执行（已写出的部分丢弃）和排队中的所有任务
+    void cancelAll();
+    bool isBusy() const;
+    // 尚未完成的任务数（包括正在执行的）
+    int pendingCount() const;
+
+signals:
+    void jobStarted(int jobId, const QString& filePath);
+    void progressChanged(int jobId, int percent);
+    // cancelled 为 true 表示任务因 cancelAll 而终止（success 同时为 false）
+    void jobFinished(int jobId, const QString& filePath, bool success, bool cancelled, const QString& errorMessage);
+
+private slots:
+    void onJobThreadFinished();
+
+private:
+    struct Job {
+        int id = 0;
+        QString filePath;
+        QSharedPointer<StitchCanvas> canvas;
+        QImage fallbackImage;
+    };
+
+    void startNextJob();
+    bool runJob(const Job& job, QString* errorMessage, bool* cancelled);
+
+    QList<Job> m_pending;
+    Job m_current;
+    QThread* m_thread = nullptr;
+    QAtomicInt m_cancelRequested;
+    bool m_currentSuccess = false;  // 由导出线程写入，线程结束后在 GUI 线程读取
+    bool m_currentCancelled = false;
+    QString m_currentError;
+    int m_nextJobId = 1;
+};
+
+#endif // EXPORTQUEUE_H
@@ -0,0 +1,149 @@
+#include "frameanalysis.h"
+#include <QHash>
+#include <opencv2/imgproc.hpp>
+
+const int FrameAnalysis::PYRAMID_LEVELS;
+const int FrameAnalysis::PYRAMID_MIN_HEIGHT;
+const int FrameAnalysis::SAMPLED_HASH_ROWS;
+
+namespace {
+    // FNV-1a 64 位组合，用于把多行哈希合成一个指纹
+    inline quint64 fnvCombine(quint64 hash, quint64 value)
+    {
+        const quint64 prime = 1099511628211ULL;
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= prime;
+        }
+        return hash;
+    }
+}
+
+FrameAnalysis::FrameAnalysis(const QImage& frame, qint64 timestampMs)
+{
+    if (frame.isNull()) {
+        return;
+    }
+
+    auto data = std::make_shared<Data>();
+    data->timestampMs = timestampMs;
+    switch (frame.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        data->image = frame;
+        break;
+    default:
+        data->image = frame.convertToFormat(QImage::Format_RGB32);
+        break;
+    }
+
+    const QImage& img = data->image;
+    const int w = img.width();
+    const int h = img.height();
+
+    // 灰度平面：直接从 BGRA 转换，跳过中间的 BGR 拷贝
+    const cv::Mat bgra(h, w, CV_8UC4, const_cast<uchar*>(img.constBits()), img.bytesPerLine());
+    cv::cvtColor(bgra, data->gray, cv::COLOR_BGRA2GRAY);
+
+    data->pyramid.push_back(data->gray);
+    for (int level = 1; level < PYRAMID_LEVELS; ++level) {
+        const cv::Mat& prev = data->pyramid.back();
+        if (prev.rows / 2 < PYRAMID_MIN_HEIGHT || prev.cols / 2 < 1) {
+            break;
+        }
+        cv::Mat down;
+        cv::pyrDown(prev, down);
+        data->pyramid.push_back(down);
+    }
+
+    // 行哈希（原始像素）与行灰度方差
+    data->rowHashes.resize(h);
+    data->rowVariance.resize(h);
+    const size_t rowBytes = size_t(w) * 4;
+    for (int y = 0; y < h; ++y) {
+        data->rowHashes[y] = quint64(qHashBits(img.constScanLine(y), rowBytes, 0));
+
+        const uchar* line = data->gray.ptr<uchar>(y);
+        quint64 sum = 0;
+        quint64 sum2 = 0;
+        for (int x = 0; x < w; ++x) {
+            const quint64 v = line[x];
+            sum += v;
+            sum2 += v * v;
+        }
+        const double mean = double(sum) / w;
+        data->rowVariance[y] = qMax(0.0, double(sum2) / w - mean * mean);
+    }
+
+    m_data = data;
+}
+
+const QImage& FrameAnalysis::image() const
+{
+    static const QImage empty;
+    return m_data ? m_data->image : empty;
+}
+
+const cv::Mat& FrameAnalysis::gray() const
+{
+    static const cv::Mat empty;
+    return m_data ? m_data->gray : empty;
+}
+
+const std::vector<cv::Mat>& FrameAnalysis::pyramid() const
+{
+    static const std::vector<cv::Mat> empty;
+    return m_data ? m_data->pyramid : empty;
+}
+
+const QVector<quint64>& FrameAnalysis::rowHashes() const
+{
+    static const QVector<quint64> empty;
+    return m_data ? m_data->rowHashes : empty;
+}
+
+const QVector<double>& FrameAnalysis::rowVariance() const
+{
+    static const QVector<double> empty;
+    return m_data ? m_data->rowVariance : empty;
+}
+
+QString FrameAnalysis::rowsFingerprint(int top, int rowCount) const
+{
+    if (!m_data) {
+        return QString();
+    }
+    const int begin = qBound(0, top, height());
+    const int end = qBound(begin, top + rowCount, height());
+    if (end <= begin) {
+        return QString();
+    }
+
+    quint64 hash = 14695981039346656037ULL;
+    hash = fnvCombine(hash, quint64(width()));
+    hash = fnvCombine(hash, quint64(end - begin));
+    for (int y = begin; y < end; ++y) {
+        hash = fnvCombine(hash, m_data->rowHashes[y]);
+    }
+    return QString::number(hash, 16);
+}
+
+quint64 FrameAnalysis::sampledRowsHash(const QImage& frame)
+{
+    if (frame.isNull()) {
+        return 0;
+    }
+    // 滚动会让所有行一起变化，抽样若干整行足以区分；像素格式不同的帧按各自的字节计算
+    const int h = frame.height();
+    const int rows = qMin(h, SAMPLED_HASH_ROWS);
+    const size_t rowBytes = size_t(frame.width()) * frame.depth() / 8;
+    quint64 hash = 14695981039346656037ULL;
+    hash = fnvCombine(hash, quint64(frame.width()));
+    hash = fnvCombine(hash, quint64(h));
+    for (int i = 0; i < rows; ++i) {
+        const int y = (rows > 1) ? int(qint64(i) * (h - 1) / (rows - 1)) : 0;
+        hash = fnvCombine(hash, quint64(qHashBits(frame.constScanLine(y), rowBytes, 0)));
+    }
+    return hash;
+}
@@ -0,0 +1,61 @@
+#ifndef FRAMEANALYSIS_H
+#define FRAMEANALYSIS_H
+
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// 单帧分析结果：每帧只计算一次，并作为下一帧的“上一帧”继续使用。
+// 检测（灰度/金字塔）、去重（行哈希指纹）、固定区域识别（行方差）都直接读取这里的结果，
+// 不再各自拷贝、转换格式。数据只读且隐式共享，复制开销很小，可在流水线阶段之间传递。
+class FrameAnalysis
+{
+public:
+    FrameAnalysis() = default;
+    explicit FrameAnalysis(const QImage& frame, qint64 timestampMs = 0);
+
+    bool isNull() const { return !m_data; }
+    int width() const { return m_data ? m_data->image.width() : 0; }
+    int height() const { return m_data ? m_data->image.height() : 0; }
+    // 抓取时间（毫秒），用于估计滚动速度
+    qint64 timestampMs() const { return m_data ? m_data->timestampMs : 0; }
+
+    // 32 位格式的原始帧（RGB32/ARGB32，其他格式在分析时转换一次）
+    const QImage& image() const;
+    // 灰度平面（CV_8UC1，数据由本对象持有）
+    const cv::Mat& gray() const;
+    // 灰度金字塔：第 0 层即 gray()，之后每层宽高减半
+    const std::vector<cv::Mat>& pyramid() const;
+    // 每行像素的 64 位哈希，内容完全相同的行哈希相同
+    const QVector<quint64>& rowHashes() const;
+    // 每行灰度方差，单调色带（工具栏、状态栏）方差很小
+    const QVector<double>& rowVariance() const;
+
+    // 指定行范围的内容指纹（由行哈希组合，不需要再次扫描像素）
+    QString rowsFingerprint(int top, int rowCount) const;
+
+    // 只对均匀抽样的若干行计算的 64 位哈希，用于在完整分析之前快速判断画面是否完全没变
+    static quint64 sampledRowsHash(const QImage& frame);
+
+    static const int PYRAMID_LEVELS = 4;        // 金字塔层数（含原始分辨率，最低 1/8）
+    static const int PYRAMID_MIN_HEIGHT = 32;   // 低于该高度不再继续缩小
+    static const int SAMPLED_HASH_ROWS = 32;    // 快速哈希抽样的行数
+
+private:
+    struct Data {
+        QImage image;
+        qint64 timestampMs = 0;
+        cv::Mat gray;
+        std::vector<cv::Mat> pyramid;
+        QVector<quint64> rowHashes;
+        QVector<double> rowVariance;
+    };
+
+    std::shared_ptr<const Data> m_data;
+};
+
+#endif // FRAMEANALYSIS_H
@@ -0,0 +1,134 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// 有界无锁环形队列（Vyukov 有界队列算法，每个槽位带序号）
+// 典型用法是单生产者（截图线程）/单消费者（拼接），容量固定为 2 的幂。
+// 队列满时生产者使用 pushDropOldest() 丢弃最旧的一项再写入：消费者落后时总是保留最新的帧。
+// 丢弃操作本质上是生产者临时充当第二个消费者，该算法对多消费者同样安全，因此不需要加锁。
+template <typename T>
+class FrameRing
+{
+public:
+    explicit FrameRing(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // 写入一项；队列满时返回 false，value 保持不变
+    bool tryPush(T& value)
+    {
+        Cell* cell = nullptr;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 取出最旧的一项；队列为空时返回 false
+    bool tryPop(T& out)
+    {
+        Cell* cell = nullptr;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->data);
+        cell->data = T();  // 及时释放帧数据，避免槽位长期持有大块内存
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 生产者写入：队列满时丢弃最旧的项直到写入成功，返回本次丢弃的数量
+    int pushDropOldest(T value)
+    {
+        int dropped = 0;
+        while (!tryPush(value)) {
+            T oldest;
+            if (tryPop(oldest)) {
+                ++dropped;
+            }
+        }
+        if (dropped > 0) {
+            m_dropped.fetch_add(quint64(dropped), std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // 近似长度（并发读写时仅供统计使用）
+    size_t sizeApprox() const
+    {
+        const size_t enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+        const size_t dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // 仅在没有并发生产者时调用（例如截图线程已停止）
+    void clear()
+    {
+        T item;
+        while (tryPop(item)) {
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,65 @@
+#include "hammingindex.h"
+#include "perceptualhash.h"
+
+void HammingIndex::insert(quint64 hash, int value)
+{
+    Node node;
+    node.hash = hash;
+    node.value = value;
+    if (m_nodes.empty()) {
+        m_nodes.push_back(node);
+        return;
+    }
+
+    // 从根开始，沿“距离相同”的子节点往下走，直到找到空位
+    int current = 0;
+    while (true) {
+        const int d = PerceptualHash::distance(hash, m_nodes[current].hash);
+        int next = -1;
+        for (const auto& child : m_nodes[current].children) {
+            if (child.first == d) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next < 0) {
+            const int index = static_cast<int>(m_nodes.size());
+            m_nodes[current].children.emplace_back(d, index);
+            m_nodes.push_back(node);
+            return;
+        }
+        current = next;
+    }
+}
+
+QList<int> HammingIndex::query(quint64 hash, int maxDistance) const
+{
+    QList<int> result;
+    if (m_nodes.empty()) {
+        return result;
+    }
+
+    std::vector<int> pending;
+    pending.push_back(0);
+    while (!pending.empty()) {
+        const Node& node = m_nodes[pending.back()];
+        pending.pop_back();
+
+        const int d = PerceptualHash::distance(hash, node.hash);
+        if (d <= maxDistance) {
+            result.append(node.value);
+        }
+        // 只有到本节点距离落在 [d - r, d + r] 内的子树才可能包含结果
+        for (const auto& child : node.children) {
+            if (child.first >= d - maxDistance && child.first <= d + maxDistance) {
+                pending.push_back(child.second);
+            }
+        }
+    }
+    return result;
+}
+
+void HammingIndex::clear()
+{
+    m_nodes.clear();
+}
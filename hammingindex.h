@@ -0,0 +1,33 @@
+#ifndef HAMMINGINDEX_H
+#define HAMMINGINDEX_H
+
+#include <QList>
+#include <QtGlobal>
+#include <utility>
+#include <vector>
+
+// 64 位哈希的汉明距离索引（BK 树）：按距离三角不等式剪枝，
+// 查询“与给定哈希距离不超过 r 的所有条目”只需访问树中很小一部分节点。
+// 不支持单独删除条目，需要淘汰时由调用方 clear() 后重新插入。
+class HammingIndex
+{
+public:
+    void insert(quint64 hash, int value);
+    // 返回距离 <= maxDistance 的所有条目的 value（顺序不定）
+    QList<int> query(quint64 hash, int maxDistance) const;
+
+    void clear();
+    int size() const { return static_cast<int>(m_nodes.size()); }
+    bool isEmpty() const { return m_nodes.empty(); }
+
+private:
+    struct Node {
+        quint64 hash = 0;
+        int value = 0;
+        std::vector<std::pair<int, int>> children;  // (到本节点的距离, 子节点下标)
+    };
+
+    std::vector<Node> m_nodes;  // m_nodes[0] 为根
+};
+
+#endif // HAMMINGINDEX_H
@@ -0,0 +1,54 @@
+#include "intervalindex.h"
+#include <climits>
+
+void IntervalIndex::insert(int top, int bottom, int value)
+{
+    if (bottom <= top) {
+        return;
+    }
+    remove(value);
+
+    Interval interval;
+    interval.top = top;
+    interval.bottom = bottom;
+    interval.value = value;
+    m_sorted.insert(interval);
+    m_intervals.insert(value, interval);
+    m_maxLength = qMax(m_maxLength, bottom - top);
+}
+
+void IntervalIndex::remove(int value)
+{
+    auto it = m_intervals.find(value);
+    if (it == m_intervals.end()) {
+        return;
+    }
+    m_sorted.erase(it.value());
+    m_intervals.erase(it);
+}
+
+QList<int> IntervalIndex::query(int top, int bottom) const
+{
+    QList<int> result;
+    if (bottom <= top || m_sorted.empty()) {
+        return result;
+    }
+
+    // 从可能相交的最小起点开始，起点到达 bottom 即可停止
+    Interval lower;
+    lower.top = top - m_maxLength;
+    lower.value = INT_MIN;
+    for (auto it = m_sorted.lower_bound(lower); it != m_sorted.end() && it->top < bottom; ++it) {
+        if (it->bottom > top) {
+            result.append(it->value);
+        }
+    }
+    return result;
+}
+
+void IntervalIndex::clear()
+{
+    m_sorted.clear();
+    m_intervals.clear();
+    m_maxLength = 0;
+}
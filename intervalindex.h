@@ -0,0 +1,41 @@
+#ifndef INTERVALINDEX_H
+#define INTERVALINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <set>
+
+// 一维区间索引：按区间起点排序保存，并记录出现过的最大区间长度。
+// 与 [top, bottom) 相交的区间起点必然落在 (top - 最大长度, bottom) 内，
+// 查询只需在有序集合中扫过这一小段，代价与总区间数无关（只与相交数量有关）。
+// 截图片段的高度不超过一屏，最大长度很小，非常适合这种“有序区间 + 长度上界”的结构。
+class IntervalIndex
+{
+public:
+    // 插入半开区间 [top, bottom)，value 作为唯一标识
+    void insert(int top, int bottom, int value);
+    void remove(int value);
+    // 返回与 [top, bottom) 相交的所有区间的 value（按起点升序）
+    QList<int> query(int top, int bottom) const;
+
+    void clear();
+    int size() const { return m_intervals.size(); }
+    bool isEmpty() const { return m_intervals.isEmpty(); }
+
+private:
+    struct Interval {
+        int top = 0;
+        int bottom = 0;
+        int value = 0;
+        bool operator<(const Interval& other) const
+        {
+            return top != other.top ? top < other.top : value < other.value;
+        }
+    };
+
+    std::set<Interval> m_sorted;
+    QHash<int, Interval> m_intervals;   // value -> 区间，用于删除
+    int m_maxLength = 0;                // 历史最大区间长度（删除时不回退，只会让查询略微保守）
+};
+
+#endif // INTERVALINDEX_H
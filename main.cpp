@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QLocale>
 #include <QTranslator>
 
@@ -17,7 +18,25 @@ int main(int argc, char *argv[])
             break;
         }
     }
+
+    // 命令行：录制/回放会话，用于离线复现拼接问题与基准测试
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption recordOption("record", "录制每次滚动截图的原始帧到目录或 .rsrec 文件", "path");
+    QCommandLineOption replayOption("replay", "回放录制的会话（目录或 .rsrec 文件）", "path");
+    QCommandLineOption realTimeOption("realtime", "按录制时的原始节奏回放（默认尽快回放）");
+    parser.addOption(recordOption);
+    parser.addOption(replayOption);
+    parser.addOption(realTimeOption);
+    parser.process(a);
+
     MainWindow w;
     w.show();
+    if (parser.isSet(recordOption)) {
+        w.setRecordingPath(parser.value(recordOption));
+    }
+    if (parser.isSet(replayOption)) {
+        w.startReplay(parser.value(replayOption), parser.isSet(realTimeOption));
+    }
     return a.exec();
 }
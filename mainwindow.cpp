@@ -99,6 +99,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_selectionOverlay(nullptr)
     , m_screenshotCapture(nullptr)
     , m_previewWindow(nullptr)
+    , m_exportQueue(nullptr)
     , m_isCapturing(false)
     , m_startupDelaySeconds(3)
     , m_globalHotkey(nullptr)
@@ -114,6 +115,7 @@ MainWindow::MainWindow(QWidget *parent)
     m_screenshotCapture = new ScreenshotCapture(this);
     m_selectionOverlay = new SelectionOverlay(this);
     m_previewWindow = new ScreenshotPreview(this);
+    m_exportQueue = new ExportQueue(this);
     m_globalHotkey = new GlobalHotkey(this);
     
     // 创建定时器
@@ -136,6 +138,30 @@ MainWindow::~MainWindow()
 {
 }
 
+void MainWindow::setRecordingPath(const QString& path)
+{
+    m_screenshotCapture->setRecordingPath(path);
+    logMessage(QString("截图会话将录制到: %1").arg(path));
+}
+
+void MainWindow::startReplay(const QString& path, bool realTime)
+{
+    if (m_isCapturing) {
+        return;
+    }
+    
+    m_isCapturing = true;
+    enableControls(false);
+    m_previewWindow->showPreview(QRect());
+    
+    logMessage(QString("开始回放会话: %1（%2）").arg(path).arg(realTime ? "原始节奏" : "尽快回放"));
+    if (!m_screenshotCapture->startReplay(path, realTime)) {
+        m_isCapturing = false;
+        enableControls(true);
+        logMessage("回放启动失败");
+    }
+}
+
 void MainWindow::setupUI()
 {
     m_centralWidget = new QWidget(this);
@@ -227,6 +253,12 @@ void MainWindow::setupConnections()
     // 预览窗口连接
     connect(m_previewWindow, &ScreenshotPreview::saveRequested, this, &MainWindow::onSaveRequested);
     connect(m_previewWindow, &ScreenshotPreview::closeRequested, this, &MainWindow::onPreviewCloseRequested);
+    connect(m_previewWindow, &ScreenshotPreview::exportCancelRequested, m_exportQueue, &ExportQueue::cancelAll);
+    
+    // 后台导出连接
+    connect(m_exportQueue, &ExportQueue::jobStarted, this, &MainWindow::onExportStarted);
+    connect(m_exportQueue, &ExportQueue::progressChanged, this, &MainWindow::onExportProgress);
+    connect(m_exportQueue, &ExportQueue::jobFinished, this, &MainWindow::onExportFinished);
     
     // 全局快捷键连接
     connect(m_globalHotkey, &GlobalHotkey::activated, this, &MainWindow::onHotkeyTriggered);
@@ -271,6 +303,15 @@ void MainWindow::loadSettings()
     m_startupDelaySeconds = m_settings->value("startupDelay", 3).toInt();
     m_intervalSpinBox->setValue(m_settings->value("detectionInterval", 100).toInt());
     m_delaySpinBox->setValue(m_startupDelaySeconds);
+    
+    // 截图后端（auto/x11-shm/qt），便于比较不同后端的抓取耗时
+    m_screenshotCapture->setCaptureBackend(m_settings->value("captureBackend", "auto").toString());
+    // 滚动位移估计方式（rows/template/phase）
+    m_screenshotCapture->setScrollMatcher(m_settings->value("scrollMatcher", "rows").toString());
+    // 按位置配准拼接（关闭时使用基于内容相似度的去重）
+    m_screenshotCapture->setRegistrationEnabled(m_settings->value("registration", true).toBool());
+    // 长图画布常驻内存预算（MB，0 表示不限制），超出部分换出到临时文件
+    m_screenshotCapture->setCanvasMemoryBudget(m_settings->value("canvasMemoryBudgetMB", 512).toInt());
 }
 
 void MainWindow::saveSettings()
@@ -413,6 +454,12 @@ void MainWindow::onStopScrollScreenshot()
 
     m_screenshotCapture->stopScrollCapture();
     
+    const CaptureStats stats = m_screenshotCapture->captureStats();
+    logMessage(QString("截图后端 %1：抓取 %2 次，平均 %3 ms")
+               .arg(m_screenshotCapture->captureBackendName())
+               .arg(stats.grabCount)
+               .arg(stats.averageGrabMs(), 0, 'f', 2));
+    
     m_isCapturing = false;
     enableControls(true);
     
@@ -421,10 +468,10 @@ void MainWindow::onStopScrollScreenshot()
     // 显示工具窗口
     showToolWindows();
     
-    // 确保预览窗口显示最终结果
-    QPixmap finalImage = m_screenshotCapture->getCombinedImage();
+    // 确保预览窗口显示最终结果（只取预览图，长图本身留在分块画布中）
+    QPixmap finalImage = m_screenshotCapture->getPreviewImage();
     if (!finalImage.isNull() && m_previewWindow) {
-        m_previewWindow->setFinalImage(finalImage);
+        m_previewWindow->setFinalImage(finalImage, m_screenshotCapture->combinedImageSize());
         if (!m_previewWindow->isVisible()) {
             m_previewWindow->show();
             m_previewWindow->raise();
@@ -485,9 +532,9 @@ void MainWindow::onCaptureStatusChanged(const QString& status)
     // 如果状态显示开始监听滚动或截图进行中，且预览窗口可见，更新预览内容
     if ((status.contains("监听滚动") || status.contains("截图")) && 
         m_previewWindow && m_previewWindow->isVisible()) {
-        QPixmap currentCombined = m_screenshotCapture->getCurrentCombinedImage();
-        if (!currentCombined.isNull()) {
-            m_previewWindow->updateRealTimePreview(currentCombined);
+        QPixmap currentPreview = m_screenshotCapture->getPreviewImage();
+        if (!currentPreview.isNull()) {
+            m_previewWindow->updateRealTimePreview(currentPreview, m_screenshotCapture->combinedImageSize());
             logMessage("状态变更时更新预览");
         }
     }
@@ -495,13 +542,10 @@ void MainWindow::onCaptureStatusChanged(const QString& status)
 
 void MainWindow::onNewImageCaptured(const QPixmap& image)
 {
-    Q_UNUSED(image)
-    
-    // 获取当前拼接的图片并显示在预览窗口
-    QPixmap currentCombined = m_screenshotCapture->getCurrentCombinedImage();
-    if (!currentCombined.isNull()) {
+    // 信号携带的是长图预览（按图块缩小拼接），实际尺寸另行获取
+    if (!image.isNull()) {
         // 更新预览窗口的实时预览
-        m_previewWindow->updateRealTimePreview(currentCombined);
+        m_previewWindow->updateRealTimePreview(image, m_screenshotCapture->combinedImageSize());
         
         // 确保预览窗口可见
         if (!m_previewWindow->isVisible()) {
@@ -513,10 +557,17 @@ void MainWindow::onNewImageCaptured(const QPixmap& image)
     logMessage("捕获新图片片段，预览已更新");
 }
 
-void MainWindow::onCaptureFinished(const QPixmap& combinedImage)
+void MainWindow::onCaptureFinished(const QPixmap& preview)
 {
+    // 回放结束等由截图模块主动结束的情况，恢复界面状态
+    if (m_isCapturing && !m_screenshotCapture->isCapturing()) {
+        m_isCapturing = false;
+        enableControls(true);
+    }
+    
     // 截图完成后显示最终结果
-    m_previewWindow->setFinalImage(combinedImage);
+    const QSize fullSize = m_screenshotCapture->combinedImageSize();
+    m_previewWindow->setFinalImage(preview, fullSize);
     m_previewWindow->show();
     m_previewWindow->raise();
     m_previewWindow->activateWindow();
@@ -526,7 +577,7 @@ void MainWindow::onCaptureFinished(const QPixmap& combinedImage)
     //     saveScreenshot();
     // }
     
-    logMessage(QString("截图完成，尺寸：%1x%2").arg(combinedImage.width()).arg(combinedImage.height()));
+    logMessage(QString("截图完成，尺寸：%1x%2").arg(fullSize.width()).arg(fullSize.height()));
 }
 
 void MainWindow::onCaptureFinishedFromOverlay()
@@ -597,19 +648,16 @@ void MainWindow::showToolWindows()
 
 void MainWindow::saveScreenshot()
 {
-    QPixmap finalImage = m_screenshotCapture->getCombinedImage();
-    
-    // 如果没有最终图片，但正在捕获中，尝试获取当前的实时拼接图片
-    if (finalImage.isNull() && m_isCapturing) {
-        finalImage = m_screenshotCapture->getCurrentCombinedImage();
-        logMessage("保存当前截图进度");
-    }
-    
-    if (finalImage.isNull()) {
+    // 只检查尺寸，不合成整张长图；截图进行中保存的是当前进度
+    const QSize imageSize = m_screenshotCapture->combinedImageSize();
+    if (imageSize.isEmpty()) {
         QMessageBox::warning(this, "警告", "没有可保存的截图");
         logMessage("保存失败：没有可用的截图数据");
         return;
     }
+    if (m_isCapturing) {
+        logMessage("保存当前截图进度");
+    }
     
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
     QString defaultName = QString("screenshot_%1.png").arg(timestamp);
@@ -624,23 +672,43 @@ void MainWindow::saveScreenshot()
         QFileInfo fileInfo(filePath);
         m_lastSavePath = fileInfo.absolutePath();
         
-        if (finalImage.save(filePath)) {
-            logMessage(QString("截图已保存: %1，尺寸: %2x%3").arg(filePath).arg(finalImage.width()).arg(finalImage.height()));
-            QMessageBox::information(this, "成功", "截图保存成功！");
-            
-            // 询问是否打开文件位置
-            QMessageBox::StandardButton reply = QMessageBox::question(
-                this, "打开位置", "是否打开文件所在位置？",
-                QMessageBox::Yes | QMessageBox::No
-            );
-            
-            if (reply == QMessageBox::Yes) {
-                QDesktopServices::openUrl(QUrl::fromLocalFile(fileInfo.absolutePath()));
-            }
-        } else {
-            logMessage("保存截图失败");
-            QMessageBox::critical(this, "错误", "保存截图失败！");
-        }
+        // 编码与写文件在后台进行，完成后在 onExportFinished 中提示；期间可以继续开始新的截图
+        m_exportQueue->enqueue(filePath, m_screenshotCapture->canvas(), m_screenshotCapture->baseImage());
+        logMessage(QString("截图加入导出队列: %1，尺寸: %2x%3").arg(filePath).arg(imageSize.width()).arg(imageSize.height()));
+    }
+}
+
+void MainWindow::onExportStarted(int jobId, const QString& filePath)
+{
+    Q_UNUSED(jobId)
+    m_previewWindow->setExportStarted(QFileInfo(filePath).fileName(), m_exportQueue->pendingCount() - 1);
+    updateStatus(QString("正在导出 %1...").arg(QFileInfo(filePath).fileName()));
+}
+
+void MainWindow::onExportProgress(int jobId, int percent)
+{
+    Q_UNUSED(jobId)
+    m_previewWindow->setExportProgress(percent);
+}
+
+void MainWindow::onExportFinished(int jobId, const QString& filePath, bool success, bool cancelled, const QString& errorMessage)
+{
+    Q_UNUSED(jobId)
+    if (!m_exportQueue->isBusy()) {
+        m_previewWindow->setExportFinished();
+    }
+    
+    if (success) {
+        logMessage(QString("截图已保存: %1").arg(filePath));
+        updateStatus("截图保存成功！");
+        return;
+    }
+    
+    logMessage(QString("保存截图失败: %1 (%2)").arg(filePath).arg(errorMessage));
+    updateStatus(QString("保存截图失败: %1").arg(errorMessage));
+    // 截图进行中不弹出模态对话框，避免打断滚动；取消是用户主动操作，也不提示
+    if (!m_isCapturing && !cancelled) {
+        QMessageBox::critical(this, "错误", QString("保存截图失败！\n%1").arg(errorMessage));
     }
 }
 
@@ -704,9 +772,9 @@ void MainWindow::showPreviewOutsideCaptureArea()
     m_previewWindow->showPreview(m_selectedRect);
     
     // 如果已经有拼接的图片，立即显示
-    QPixmap currentCombined = m_screenshotCapture->getCurrentCombinedImage();
-    if (!currentCombined.isNull()) {
-        m_previewWindow->updateRealTimePreview(currentCombined);
+    QPixmap currentPreview = m_screenshotCapture->getPreviewImage();
+    if (!currentPreview.isNull()) {
+        m_previewWindow->updateRealTimePreview(currentPreview, m_screenshotCapture->combinedImageSize());
     }
     
     logMessage(QString("预览窗口已移动到截图区域外: (%1, %2)").arg(newPos.x()).arg(newPos.y()));
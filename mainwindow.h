@@ -36,6 +36,7 @@
 #include "selectionoverlay.h"
 #include "screenshotpreview.h"
 #include "globalhotkey.h"
+#include "exportqueue.h"
 
 QT_BEGIN_NAMESPACE
 class QVBoxLayout;
@@ -55,6 +56,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // 会话录制/回放（命令行 --record / --replay）
+    void setRecordingPath(const QString& path);
+    void startReplay(const QString& path, bool realTime);
+
 private slots:
     void onStartScrollScreenshot();
     void onStopScrollScreenshot();
@@ -62,7 +67,7 @@ private slots:
     void onSelectionCancelled();
     void onCaptureStatusChanged(const QString& status);
     void onNewImageCaptured(const QPixmap& image);
-    void onCaptureFinished(const QPixmap& combinedImage);
+    void onCaptureFinished(const QPixmap& preview);
     void onCaptureFinishedFromOverlay();  // 来自选择覆盖层的完成信号
     void onSaveRequested();
     void onPreviewCloseRequested();
@@ -70,6 +75,10 @@ private slots:
     void onStartupDelayFinished();
     void onHotkeyTriggered();  // 快捷键触发
     void onShowSettings();     // 显示设置对话框
+    // 后台导出
+    void onExportStarted(int jobId, const QString& filePath);
+    void onExportProgress(int jobId, int percent);
+    void onExportFinished(int jobId, const QString& filePath, bool success, bool cancelled, const QString& errorMessage);
 
 private:
     void setupUI();
@@ -101,6 +110,7 @@ private:
     SelectionOverlay *m_selectionOverlay;
     ScreenshotCapture *m_screenshotCapture;
     ScreenshotPreview *m_previewWindow;
+    ExportQueue *m_exportQueue;
     
     QRect m_selectedRect;
     bool m_isCapturing;
@@ -0,0 +1,45 @@
+#include "perceptualhash.h"
+#include <QImage>
+#include <QtAlgorithms>
+#include <opencv2/imgproc.hpp>
+
+quint64 PerceptualHash::dHash(const cv::Mat& gray)
+{
+    if (gray.empty() || gray.type() != CV_8UC1) {
+        return 0;
+    }
+
+    // 面积插值缩小，相当于对每个格子求平均，噪声和文字笔画细节被平滑掉
+    cv::Mat small;
+    cv::resize(gray, small, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+
+    quint64 hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar* row = small.ptr<uchar>(y);
+        for (int x = 0; x < 8; ++x) {
+            hash <<= 1;
+            if (row[x] < row[x + 1]) {
+                hash |= 1;
+            }
+        }
+    }
+    return hash;
+}
+
+quint64 PerceptualHash::dHash(const QImage& image)
+{
+    if (image.isNull()) {
+        return 0;
+    }
+
+    const QImage img = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+    const cv::Mat bgra(img.height(), img.width(), CV_8UC4, const_cast<uchar*>(img.constBits()), img.bytesPerLine());
+    cv::Mat gray;
+    cv::cvtColor(bgra, gray, cv::COLOR_BGRA2GRAY);
+    return dHash(gray);
+}
+
+int PerceptualHash::distance(quint64 a, quint64 b)
+{
+    return qPopulationCount(a ^ b);
+}
@@ -0,0 +1,21 @@
+#ifndef PERCEPTUALHASH_H
+#define PERCEPTUALHASH_H
+
+#include <QtGlobal>
+#include <opencv2/core.hpp>
+
+class QImage;
+
+// 64 位感知哈希（dHash）：缩小到 9x8 灰度后比较左右相邻像素的明暗。
+// 内容几乎相同的图像哈希只差几位，用汉明距离衡量相似程度，不受轻微缩放、抗锯齿差异影响。
+namespace PerceptualHash {
+    // 灰度图（CV_8UC1）的哈希，可直接传入帧分析灰度平面的行范围，不需要拷贝
+    quint64 dHash(const cv::Mat& gray);
+    // 任意格式 QImage 的哈希（内部转换为灰度）
+    quint64 dHash(const QImage& image);
+
+    // 两个哈希之间不同的位数（0~64）
+    int distance(quint64 a, quint64 b);
+}
+
+#endif // PERCEPTUALHASH_H
@@ -0,0 +1,208 @@
+#include "pixelkernels.h"
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QtAlgorithms>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PIXELKERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PIXELKERNELS_TARGET(features)
+#else
+#define PIXELKERNELS_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
+namespace {
+    // ---- 标量实现（同时用于 SIMD 版本的尾部） ----
+
+    inline int rgbAbsDiff(quint32 p1, quint32 p2)
+    {
+        const int b = qAbs(int(p1 & 0xff) - int(p2 & 0xff));
+        const int g = qAbs(int((p1 >> 8) & 0xff) - int((p2 >> 8) & 0xff));
+        const int r = qAbs(int((p1 >> 16) & 0xff) - int((p2 >> 16) & 0xff));
+        return r + g + b;
+    }
+
+    int countSimilarScalar(const quint32* a, const quint32* b, int count, int threshold)
+    {
+        int similar = 0;
+        for (int i = 0; i < count; ++i) {
+            if (rgbAbsDiff(a[i], b[i]) < threshold) {
+                ++similar;
+            }
+        }
+        return similar;
+    }
+
+#ifdef PIXELKERNELS_X86
+    // ---- SSE4.1：每次 4 个像素 ----
+    // 逐字节绝对差 -> 屏蔽 alpha -> maddubs 两两相加 -> madd 得到每像素 32 位和
+
+    PIXELKERNELS_TARGET("sse4.1")
+    int countSimilarSse4(const quint32* a, const quint32* b, int count, int threshold)
+    {
+        const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+        const __m128i ones8 = _mm_set1_epi8(1);
+        const __m128i ones16 = _mm_set1_epi16(1);
+        const __m128i limit = _mm_set1_epi32(threshold);
+        int similar = 0;
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+            diff = _mm_and_si128(diff, rgbMask);
+            const __m128i sums = _mm_madd_epi16(_mm_maddubs_epi16(diff, ones8), ones16);
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(sums, limit)));
+            similar += qPopulationCount(quint32(mask));
+        }
+        return similar + countSimilarScalar(a + i, b + i, count - i, threshold);
+    }
+
+    // ---- AVX2：每次 8 个像素，算法同上 ----
+
+    PIXELKERNELS_TARGET("avx2")
+    int countSimilarAvx2(const quint32* a, const quint32* b, int count, int threshold)
+    {
+        const __m256i rgbMask = _mm256_set1_epi32(0x00ffffff);
+        const __m256i ones8 = _mm256_set1_epi8(1);
+        const __m256i ones16 = _mm256_set1_epi16(1);
+        const __m256i limit = _mm256_set1_epi32(threshold);
+        int similar = 0;
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i diff = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+            diff = _mm256_and_si256(diff, rgbMask);
+            const __m256i sums = _mm256_madd_epi16(_mm256_maddubs_epi16(diff, ones8), ones16);
+            // a < b 等价于 b > a
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(limit, sums)));
+            similar += qPopulationCount(quint32(mask));
+        }
+        return similar + countSimilarScalar(a + i, b + i, count - i, threshold);
+    }
+
+    // 运行时检测 CPU 能力
+    bool cpuHasAvx2()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {0, 0, 0, 0};
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    bool cpuHasSse4()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {0, 0, 0, 0};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 19)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.1");
+#endif
+    }
+#endif // PIXELKERNELS_X86
+
+    struct KernelTable {
+        int (*countSimilar)(const quint32*, const quint32*, int, int);
+        const char* name;
+    };
+
+    // 本机 CPU 支持的全部实现，按优先级从高到低排列，最后总是标量实现
+    const QList<KernelTable>& availableKernels()
+    {
+        static const QList<KernelTable> tables = []() {
+            QList<KernelTable> result;
+#ifdef PIXELKERNELS_X86
+            if (cpuHasAvx2()) {
+                result.append(KernelTable{countSimilarAvx2, "avx2"});
+            }
+            if (cpuHasSse4()) {
+                result.append(KernelTable{countSimilarSse4, "sse4"});
+            }
+#endif
+            result.append(KernelTable{countSimilarScalar, "scalar"});
+            return result;
+        }();
+        return tables;
+    }
+
+    // 首次使用时选择实现（局部静态变量的初始化是线程安全的）
+    const KernelTable& kernels()
+    {
+        return availableKernels().first();
+    }
+}
+
+int PixelKernels::countSimilarPixels(const quint32* a, const quint32* b, int count, int threshold)
+{
+    return count > 0 ? kernels().countSimilar(a, b, count, threshold) : 0;
+}
+
+int PixelKernels::countSimilarPixels(const QImage& img1, const QRect& rect1, const QImage& img2, const QRect& rect2,
+                                     int threshold, int rowStep, int* sampledPixels)
+{
+    if (sampledPixels) {
+        *sampledPixels = 0;
+    }
+    if (img1.depth() != 32 || img2.depth() != 32 || rect1.size() != rect2.size() || rect1.isEmpty()
+        || !img1.rect().contains(rect1) || !img2.rect().contains(rect2)) {
+        return 0;
+    }
+
+    const int width = rect1.width();
+    const int step = qMax(1, rowStep);
+    int similar = 0;
+    int sampled = 0;
+    for (int y = 0; y < rect1.height(); y += step) {
+        const quint32* row1 = reinterpret_cast<const quint32*>(img1.constScanLine(rect1.y() + y)) + rect1.x();
+        const quint32* row2 = reinterpret_cast<const quint32*>(img2.constScanLine(rect2.y() + y)) + rect2.x();
+        similar += countSimilarPixels(row1, row2, width, threshold);
+        sampled += width;
+    }
+    if (sampledPixels) {
+        *sampledPixels = sampled;
+    }
+    return similar;
+}
+
+const char* PixelKernels::implementationName()
+{
+    return kernels().name;
+}
+
+QStringList PixelKernels::availableImplementations()
+{
+    QStringList names;
+    for (const KernelTable& table : availableKernels()) {
+        names.append(QString::fromLatin1(table.name));
+    }
+    return names;
+}
+
+int PixelKernels::countSimilarPixels(const QString& implementation, const quint32* a, const quint32* b, int count, int threshold)
+{
+    for (const KernelTable& table : availableKernels()) {
+        if (implementation == QLatin1String(table.name)) {
+            return count > 0 ? table.countSimilar(a, b, count, threshold) : 0;
+        }
+    }
+    return -1;
+}
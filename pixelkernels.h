@@ -0,0 +1,28 @@
+#ifndef PIXELKERNELS_H
+#define PIXELKERNELS_H
+
+#include <QStringList>
+#include <QtGlobal>
+
+class QImage;
+class QRect;
+
+// 像素比较内核：直接处理 32 位扫描线（RGB32/ARGB32，内存中按 B,G,R,A 排列），只比较 RGB 三个通道。
+// x86 上运行时按 CPU 能力选择 AVX2 / SSE4.1 实现，其他平台使用标量实现，结果完全一致。
+namespace PixelKernels {
+    // 统计 |ΔR|+|ΔG|+|ΔB| < threshold 的像素个数
+    int countSimilarPixels(const quint32* a, const quint32* b, int count, int threshold);
+
+    // 两幅 32 位图像中同尺寸区域的相似像素数，每隔 rowStep 行取一行；sampledPixels 返回参与比较的像素数
+    int countSimilarPixels(const QImage& img1, const QRect& rect1, const QImage& img2, const QRect& rect2,
+                           int threshold, int rowStep, int* sampledPixels);
+
+    // 当前使用的实现："avx2"、"sse4" 或 "scalar"
+    const char* implementationName();
+    // 本机 CPU 支持的全部实现（总是包含 "scalar"），供对照测试逐个验证
+    QStringList availableImplementations();
+    // 用指定实现统计相似像素；本机不支持该实现时返回 -1
+    int countSimilarPixels(const QString& implementation, const quint32* a, const quint32* b, int count, int threshold);
+}
+
+#endif // PIXELKERNELS_H
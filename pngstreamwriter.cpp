@@ -0,0 +1,471 @@
+#include "pngstreamwriter.h"
+#include <QColor>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtEndian>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+const int PngStreamWriter::IDAT_CHUNK_SIZE;
+const int PngStreamWriter::BAND_BYTES;
+const int PngStreamWriter::MIN_BAND_ROWS;
+const int PngStreamWriter::DICTIONARY_SIZE;
+const int PngStreamWriter::PROGRESS_ROWS;
+
+namespace {
+    const int BYTES_PER_PIXEL = 4;
+
+    enum PngFilter { FilterNone = 0, FilterSub = 1, FilterUp = 2, FilterAverage = 3, FilterPaeth = 4 };
+
+    inline uchar paethPredictor(int a, int b, int c)
+    {
+        const int p = a + b - c;
+        const int pa = std::abs(p - a);
+        const int pb = std::abs(p - b);
+        const int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return uchar(a);
+        if (pb <= pc) return uchar(b);
+        return uchar(c);
+    }
+
+    // 预乘 ARGB -> 非预乘 RGBA 字节序
+    void convertRow(const uchar* argbRow, uchar* rgba, int width)
+    {
+        const QRgb* src = reinterpret_cast<const QRgb*>(argbRow);
+        for (int x = 0; x < width; ++x) {
+            const QRgb pixel = qAlpha(src[x]) == 255 ? src[x] : qUnpremultiply(src[x]);
+            rgba[0] = uchar(qRed(pixel));
+            rgba[1] = uchar(qGreen(pixel));
+            rgba[2] = uchar(qBlue(pixel));
+            rgba[3] = uchar(qAlpha(pixel));
+            rgba += BYTES_PER_PIXEL;
+        }
+    }
+
+    // 按 libpng 的经验方法为每行选择过滤方式：取过滤后字节（视为有符号数）绝对值之和最小者。
+    // 结果（首字节为过滤类型）放在 filtered 中，candidate 为同尺寸的临时缓冲
+    void filterRow(const uchar* cur, const uchar* prev, int rowBytes, QByteArray& filtered, QByteArray& candidate)
+    {
+        quint64 bestSum = ~quint64(0);
+        for (int filter = FilterNone; filter <= FilterPaeth; ++filter) {
+            uchar* out = reinterpret_cast<uchar*>(candidate.data());
+            out[0] = uchar(filter);
+            quint64 sum = 0;
+            for (int i = 0; i < rowBytes; ++i) {
+                const int a = i >= BYTES_PER_PIXEL ? cur[i - BYTES_PER_PIXEL] : 0;
+                const int b = prev[i];
+                const int c = i >= BYTES_PER_PIXEL ? prev[i - BYTES_PER_PIXEL] : 0;
+                uchar value = cur[i];
+                switch (filter) {
+                case FilterSub: value = uchar(cur[i] - a); break;
+                case FilterUp: value = uchar(cur[i] - b); break;
+                case FilterAverage: value = uchar(cur[i] - ((a + b) >> 1)); break;
+                case FilterPaeth: value = uchar(cur[i] - paethPredictor(a, b, c)); break;
+                default: break;
+                }
+                out[i + 1] = value;
+                sum += value < 128 ? value : 256 - value;
+            }
+            if (sum < bestSum) {
+                bestSum = sum;
+                filtered.swap(candidate);
+            }
+        }
+    }
+
+    int bandRowsFor(int width)
+    {
+        return qMax(PngStreamWriter::MIN_BAND_ROWS, PngStreamWriter::BAND_BYTES / (width * BYTES_PER_PIXEL + 1));
+    }
+
+    // zlib 流头（CMF/FLG），FLEVEL 只是提示信息，不影响解码
+    QByteArray zlibHeader(int level)
+    {
+        const int effective = level < 0 ? 6 : level;
+        const int flevel = effective < 2 ? 0 : effective < 6 ? 1 : effective == 6 ? 2 : 3;
+        const int cmf = 0x78;   // deflate，32KB 窗口
+        int flg = flevel << 6;
+        flg += 31 - (cmf * 256 + flg) % 31;
+        QByteArray header(2, 0);
+        header[0] = char(cmf);
+        header[1] = char(flg);
+        return header;
+    }
+
+    struct BandResult {
+        QByteArray data;        // 原始 deflate 数据（非最后一个条带以同步刷新结束，字节对齐）
+        uLong adler = 1;        // 条带未压缩数据的 adler32
+        qint64 length = 0;      // 条带未压缩数据的长度
+        bool ok = false;
+        bool done = false;
+    };
+
+    bool deflateInto(z_stream& stream, const uchar* data, int size, int flush, QByteArray& buffer, QByteArray& out)
+    {
+        stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data));
+        stream.avail_in = uInt(size);
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+            stream.avail_out = uInt(buffer.size());
+            if (deflate(&stream, flush) == Z_STREAM_ERROR) {
+                return false;
+            }
+            out.append(buffer.constData(), buffer.size() - int(stream.avail_out));
+        } while (stream.avail_out == 0);
+        return true;
+    }
+
+    // 编码一个条带 [top, bottom)：用原始 deflate 独立压缩，前一条带末尾 DICTIONARY_SIZE 字节的过滤数据作为预设字典。
+    // 字典由本条带自己重新读取并过滤前面几行得到（过滤结果是确定的），因此各条带之间没有等待关系
+    bool encodeBand(const PngStreamWriter::RowReader& readRow, int width, int top, int bottom, bool last, int level, BandResult& result)
+    {
+        const int rowBytes = width * BYTES_PER_PIXEL;
+        const int filteredBytes = rowBytes + 1;
+        const int dictionaryRows = qMin(top, (PngStreamWriter::DICTIONARY_SIZE + filteredBytes - 1) / filteredBytes);
+        const int start = top - dictionaryRows;
+
+        QByteArray argb(rowBytes, 0);
+        QByteArray current(rowBytes, 0);
+        QByteArray previous(rowBytes, 0);
+        QByteArray filtered(filteredBytes, 0);
+        QByteArray candidate(filteredBytes, 0);
+        QByteArray buffer(PngStreamWriter::IDAT_CHUNK_SIZE, 0);
+        QByteArray dictionary;
+        if (start > 0) {
+            readRow(start - 1, reinterpret_cast<uchar*>(argb.data()));
+            convertRow(reinterpret_cast<const uchar*>(argb.constData()), reinterpret_cast<uchar*>(previous.data()), width);
+        }
+
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+
+        bool ok = true;
+        result.adler = adler32(0L, Z_NULL, 0);
+        for (int y = start; ok && y < bottom; ++y) {
+            readRow(y, reinterpret_cast<uchar*>(argb.data()));
+            convertRow(reinterpret_cast<const uchar*>(argb.constData()), reinterpret_cast<uchar*>(current.data()), width);
+            filterRow(reinterpret_cast<const uchar*>(current.constData()), reinterpret_cast<const uchar*>(previous.constData()),
+                      rowBytes, filtered, candidate);
+            previous.swap(current);
+
+            if (y < top) {
+                dictionary.append(filtered);
+                continue;
+            }
+            if (y == top && !dictionary.isEmpty()) {
+                const int size = qMin(dictionary.size(), PngStreamWriter::DICTIONARY_SIZE);
+                ok = deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.constData() + dictionary.size() - size),
+                                          uInt(size)) == Z_OK;
+                dictionary = QByteArray();
+            }
+            const int flush = y + 1 < bottom ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+            result.adler = adler32(result.adler, reinterpret_cast<const Bytef*>(filtered.constData()), uInt(filtered.size()));
+            result.length += filtered.size();
+            ok = ok && deflateInto(stream, reinterpret_cast<const uchar*>(filtered.constData()), filtered.size(), flush, buffer, result.data);
+        }
+        deflateEnd(&stream);
+        return ok;
+    }
+}
+
+PngStreamWriter::PngStreamWriter(QIODevice* device, int compressionLevel)
+    : m_device(device)
+    , m_compressionLevel(compressionLevel)
+{
+}
+
+PngStreamWriter::~PngStreamWriter()
+{
+    if (m_stream) {
+        deflateEnd(m_stream);
+        delete m_stream;
+    }
+}
+
+bool PngStreamWriter::fail(const QString& message)
+{
+    if (m_error.isEmpty()) {
+        m_error = message;
+        qDebug() << "❌ PNG 写出失败:" << message;
+    }
+    return false;
+}
+
+bool PngStreamWriter::reportProgress()
+{
+    if (m_progress && !m_progress(m_rowsWritten)) {
+        m_cancelled = true;
+        return fail("已取消");
+    }
+    return true;
+}
+
+bool PngStreamWriter::writeChunk(const char* type, const QByteArray& data)
+{
+    uchar length[4];
+    qToBigEndian<quint32>(quint32(data.size()), length);
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(data.constData()), uInt(data.size()));
+    uchar crcBytes[4];
+    qToBigEndian<quint32>(quint32(crc), crcBytes);
+
+    if (m_device->write(reinterpret_cast<const char*>(length), 4) != 4 ||
+        m_device->write(type, 4) != 4 ||
+        m_device->write(data) != data.size() ||
+        m_device->write(reinterpret_cast<const char*>(crcBytes), 4) != 4) {
+        return fail(m_device->errorString());
+    }
+    return true;
+}
+
+// 把 pending 中的压缩数据按 IDAT_CHUNK_SIZE 切块写出，不足一块的留到下次（flushAll 时全部写出）
+bool PngStreamWriter::writeIdatData(QByteArray& pending, bool flushAll)
+{
+    int offset = 0;
+    while (pending.size() - offset >= IDAT_CHUNK_SIZE || (flushAll && offset < pending.size())) {
+        const int size = qMin(IDAT_CHUNK_SIZE, int(pending.size()) - offset);
+        if (!writeChunk("IDAT", QByteArray::fromRawData(pending.constData() + offset, size))) {
+            return false;
+        }
+        offset += size;
+    }
+    pending.remove(0, offset);
+    return true;
+}
+
+bool PngStreamWriter::writeHeader(int width, int height)
+{
+    if (!m_device || !m_device->isWritable()) {
+        return fail("输出设备不可写");
+    }
+    if (width <= 0 || height <= 0) {
+        return fail(QString("无效的图像尺寸 %1x%2").arg(width).arg(height));
+    }
+    m_width = width;
+    m_height = height;
+    m_rowsWritten = 0;
+
+    static const char signature[8] = { char(0x89), 'P', 'N', 'G', '\r', '\n', char(0x1a), '\n' };
+    if (m_device->write(signature, 8) != 8) {
+        return fail(m_device->errorString());
+    }
+
+    QByteArray header(13, 0);
+    uchar* h = reinterpret_cast<uchar*>(header.data());
+    qToBigEndian<quint32>(quint32(width), h);
+    qToBigEndian<quint32>(quint32(height), h + 4);
+    h[8] = 8;   // 位深
+    h[9] = 6;   // 颜色类型：RGBA
+    h[10] = 0;  // 压缩方式
+    h[11] = 0;  // 过滤方式
+    h[12] = 0;  // 不隔行
+    return writeChunk("IHDR", header);
+}
+
+bool PngStreamWriter::begin(int width, int height)
+{
+    if (!writeHeader(width, height)) {
+        return false;
+    }
+
+    const int rowBytes = width * BYTES_PER_PIXEL;
+    m_current = QByteArray(rowBytes, 0);
+    m_previous = QByteArray(rowBytes, 0);
+    m_filtered = QByteArray(rowBytes + 1, 0);
+    m_candidate = QByteArray(rowBytes + 1, 0);
+    m_output = QByteArray(IDAT_CHUNK_SIZE, 0);
+
+    m_stream = new z_stream_s;
+    std::memset(m_stream, 0, sizeof(z_stream_s));
+    if (deflateInit(m_stream, m_compressionLevel) != Z_OK) {
+        delete m_stream;
+        m_stream = nullptr;
+        return fail("zlib 初始化失败");
+    }
+    m_stream->next_out = reinterpret_cast<Bytef*>(m_output.data());
+    m_stream->avail_out = uInt(m_output.size());
+    return true;
+}
+
+bool PngStreamWriter::deflateRow(const uchar* data, int size, bool finish)
+{
+    m_stream->next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data));
+    m_stream->avail_in = uInt(size);
+    for (;;) {
+        const int ret = deflate(m_stream, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) {
+            return fail("zlib 压缩失败");
+        }
+        // 输出缓冲写满（或压缩结束）时写出一个 IDAT 块
+        if (m_stream->avail_out == 0 || (finish && ret == Z_STREAM_END)) {
+            const int produced = m_output.size() - int(m_stream->avail_out);
+            if (produced > 0 && !writeChunk("IDAT", QByteArray::fromRawData(m_output.constData(), produced))) {
+                return false;
+            }
+            m_stream->next_out = reinterpret_cast<Bytef*>(m_output.data());
+            m_stream->avail_out = uInt(m_output.size());
+        }
+        if (finish ? ret == Z_STREAM_END : m_stream->avail_in == 0) {
+            return true;
+        }
+    }
+}
+
+bool PngStreamWriter::writeRow(const uchar* argbRow)
+{
+    if (!m_stream || !m_error.isEmpty()) {
+        return fail("PNG 写出未开始");
+    }
+    if (m_rowsWritten >= m_height) {
+        return fail("写入的行数超过图像高度");
+    }
+
+    convertRow(argbRow, reinterpret_cast<uchar*>(m_current.data()), m_width);
+    filterRow(reinterpret_cast<const uchar*>(m_current.constData()), reinterpret_cast<const uchar*>(m_previous.constData()),
+              m_current.size(), m_filtered, m_candidate);
+    if (!deflateRow(reinterpret_cast<const uchar*>(m_filtered.constData()), m_filtered.size(), false)) {
+        return false;
+    }
+    m_previous.swap(m_current);
+    ++m_rowsWritten;
+    return true;
+}
+
+bool PngStreamWriter::finish()
+{
+    if (!m_stream || !m_error.isEmpty()) {
+        return fail("PNG 写出未开始");
+    }
+    if (m_rowsWritten != m_height) {
+        return fail(QString("只写入了 %1/%2 行").arg(m_rowsWritten).arg(m_height));
+    }
+    if (!deflateRow(nullptr, 0, true)) {
+        return false;
+    }
+    deflateEnd(m_stream);
+    delete m_stream;
+    m_stream = nullptr;
+    return writeChunk("IEND", QByteArray());
+}
+
+bool PngStreamWriter::writeImage(int width, int height, const RowReader& readRow)
+{
+    const int threads = QThreadPool::globalInstance()->maxThreadCount();
+    if (m_parallel && threads > 1 && width > 0 && height > bandRowsFor(width)) {
+        return writeHeader(width, height) && writeParallel(width, height, readRow, threads);
+    }
+
+    if (!begin(width, height)) {
+        return false;
+    }
+    QByteArray row(width * BYTES_PER_PIXEL, 0);
+    for (int y = 0; y < height; ++y) {
+        readRow(y, reinterpret_cast<uchar*>(row.data()));
+        if (!writeRow(reinterpret_cast<const uchar*>(row.constData()))) {
+            return false;
+        }
+        if (m_rowsWritten % PROGRESS_ROWS == 0 && !reportProgress()) {
+            return false;
+        }
+    }
+    return finish() && reportProgress();
+}
+
+// 条带在线程池中并行编码，本线程按顺序取回结果写出：zlib 头 + 各条带的原始 deflate 数据 + 用 adler32_combine
+// 合并出的整体校验和。同时在途的条带数限制为线程数的两倍，内存占用与图像高度无关
+bool PngStreamWriter::writeParallel(int width, int height, const RowReader& readRow, int threads)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int bandRows = bandRowsFor(width);
+    const int bandCount = (height + bandRows - 1) / bandRows;
+    const int maxInFlight = threads * 2;
+    const int level = m_compressionLevel;
+
+    QList<BandResult> bands(bandCount);
+    QMutex mutex;
+    QWaitCondition bandFinished;
+    int running = 0;
+
+    auto submit = [&](int index) {
+        const int top = index * bandRows;
+        const int bottom = qMin(height, top + bandRows);
+        const bool last = index == bandCount - 1;
+        BandResult* band = &bands[index];
+        {
+            QMutexLocker locker(&mutex);
+            ++running;
+        }
+        QThreadPool::globalInstance()->start([&, band, top, bottom, last]() {
+            BandResult result;
+            result.ok = encodeBand(readRow, width, top, bottom, last, level, result);
+            QMutexLocker locker(&mutex);
+            band->data.swap(result.data);
+            band->adler = result.adler;
+            band->length = result.length;
+            band->ok = result.ok;
+            band->done = true;
+            --running;
+            bandFinished.wakeAll();
+        });
+    };
+
+    QByteArray pending = zlibHeader(level);
+    uLong adler = adler32(0L, Z_NULL, 0);
+    int submitted = 0;
+    bool ok = true;
+    for (int next = 0; ok && next < bandCount; ++next) {
+        while (submitted < bandCount && submitted - next < maxInFlight) {
+            submit(submitted++);
+        }
+
+        QMutexLocker locker(&mutex);
+        while (!bands[next].done) {
+            bandFinished.wait(&mutex);
+        }
+        BandResult& band = bands[next];
+        if (!band.ok) {
+            ok = fail("条带压缩失败");
+            break;
+        }
+        pending.append(band.data);
+        band.data = QByteArray();
+        adler = adler32_combine(adler, band.adler, z_off_t(band.length));
+        locker.unlock();
+
+        m_rowsWritten = qMin(height, (next + 1) * bandRows);
+        ok = writeIdatData(pending, false) && reportProgress();
+    }
+
+    // 出错或取消提前退出时也要等在途的条带结束，它们引用了本函数的局部变量
+    {
+        QMutexLocker locker(&mutex);
+        while (running > 0) {
+            bandFinished.wait(&mutex);
+        }
+    }
+    if (!ok) {
+        return false;
+    }
+
+    uchar trailer[4];
+    qToBigEndian<quint32>(quint32(adler), trailer);
+    pending.append(reinterpret_cast<const char*>(trailer), 4);
+    if (!writeIdatData(pending, true) || !writeChunk("IEND", QByteArray())) {
+        return false;
+    }
+
+    qDebug() << "🧵 并行 PNG 编码:" << width << "x" << height << "条带" << bandCount << "x" << bandRows << "行"
+             << "线程" << threads << "耗时" << timer.elapsed() << "ms";
+    return true;
+}
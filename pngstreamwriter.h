@@ -0,0 +1,75 @@
+#ifndef PNGSTREAMWRITER_H
+#define PNGSTREAMWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+class QIODevice;
+struct z_stream_s;
+
+// 逐行写出 PNG（8 位 RGBA，不隔行）：每行过滤后直接送入 zlib 压缩流，压缩输出攒满一块就写成 IDAT 块。
+// 内存占用只与图像宽度有关，长图导出时不需要先合成整张图像。
+// writeImage 在多核上按水平条带并行过滤与压缩（pigz 的做法），各条带的压缩数据顺序拼接成同一个 zlib 流
+class PngStreamWriter
+{
+public:
+    // 读取第 y 行（0 起）的 32 位预乘 ARGB 像素到 argbRow，可能被多个线程同时调用
+    using RowReader = std::function<void(int y, uchar* argbRow)>;
+    // writeImage 的进度回调：参数为已写出的行数，返回 false 时中止写出
+    using ProgressCallback = std::function<bool(int rowsWritten)>;
+
+    // compressionLevel 与 zlib 相同：-1 为默认级别，0~9
+    explicit PngStreamWriter(QIODevice* device, int compressionLevel = -1);
+    ~PngStreamWriter();
+
+    // 写入文件头与 IHDR
+    bool begin(int width, int height);
+    // 写入一行 32 位预乘 ARGB 像素（QImage::Format_ARGB32_Premultiplied 的扫描线）
+    bool writeRow(const uchar* argbRow);
+    // 结束压缩流，写入剩余 IDAT 与 IEND；必须已写满 height 行
+    bool finish();
+
+    // 写出整幅图像：线程池有多个线程且图像超过一个条带时并行编码，否则逐行写出
+    bool writeImage(int width, int height, const RowReader& readRow);
+    void setProgressCallback(const ProgressCallback& callback) { m_progress = callback; }
+    // 关闭后 writeImage 总是逐行写出（用于对照测试，或需要限制 CPU 占用的场合）
+    void setParallelEnabled(bool enabled) { m_parallel = enabled; }
+    bool isCancelled() const { return m_cancelled; }
+
+    int rowsWritten() const { return m_rowsWritten; }
+    QString errorString() const { return m_error; }
+
+    static const int IDAT_CHUNK_SIZE = 64 * 1024;       // 单个 IDAT 块的最大数据量
+    static const int BAND_BYTES = 1024 * 1024;          // 并行编码时每个条带的目标未压缩字节数
+    static const int MIN_BAND_ROWS = 64;                // 条带的最少行数
+    static const int DICTIONARY_SIZE = 32 * 1024;       // deflate 窗口大小，即条带之间传递的预设字典长度
+    static const int PROGRESS_ROWS = 256;               // 逐行写出时每隔多少行报告一次进度
+
+private:
+    bool writeHeader(int width, int height);
+    bool writeChunk(const char* type, const QByteArray& data);
+    bool writeIdatData(QByteArray& pending, bool flushAll);
+    bool deflateRow(const uchar* data, int size, bool finish);
+    bool writeParallel(int width, int height, const RowReader& readRow, int threads);
+    bool reportProgress();
+    bool fail(const QString& message);
+
+    QIODevice* m_device;
+    int m_compressionLevel;
+    z_stream_s* m_stream = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    int m_rowsWritten = 0;
+    QByteArray m_current;       // 当前行（RGBA）
+    QByteArray m_previous;      // 上一行（RGBA，首行之前为全 0）
+    QByteArray m_filtered;      // 选中的过滤结果（首字节为过滤类型）
+    QByteArray m_candidate;     // 正在尝试的过滤结果
+    QByteArray m_output;        // 压缩输出缓冲，满 IDAT_CHUNK_SIZE 写出一块
+    ProgressCallback m_progress;
+    bool m_cancelled = false;
+    bool m_parallel = true;
+    QString m_error;
+};
+
+#endif // PNGSTREAMWRITER_H
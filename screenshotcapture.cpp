@@ -1,4 +1,7 @@
 #include "screenshotcapture.h"
+#include "captureworker.h"
+#include "pixelkernels.h"
+#include "perceptualhash.h"
 #include <QPainter>
 #include <QDateTime>
 #include <QDebug>
@@ -6,8 +9,10 @@
 #include <QMessageBox>
 #include <cmath>
 #include <algorithm>
-#include <QCryptographicHash> // Added for content fingerprinting
+#include <vector>
+#include <QHash>
 #include <QThread>            // Added for msleep function
+#include <QCoreApplication>
 // 新增：OpenCV 头
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
@@ -19,22 +24,34 @@ const int ScreenshotCapture::OVERLAP_SEARCH_HEIGHT;
 const int ScreenshotCapture::MIN_NEW_CONTENT_HEIGHT;
 const int ScreenshotCapture::MIN_OVERLAP_HEIGHT;
 const int ScreenshotCapture::MAX_ALLOWED_DUPLICATES;
+const int ScreenshotCapture::FRAME_RING_CAPACITY;
+const int ScreenshotCapture::PIPELINE_STAGE_CAPACITY;
 const int ScreenshotCapture::TEMPLATE_HEIGHT;
 const int ScreenshotCapture::FIXED_REGION_DETECTION_HEIGHT;
+const int ScreenshotCapture::ROW_SIGNATURE_MIN_VOTES;
+const int ScreenshotCapture::PYRAMID_MIN_TEMPLATE_ROWS;
+const int ScreenshotCapture::PHASH_MATCH_DISTANCE;
+const int ScreenshotCapture::PHASH_SIMILAR_DISTANCE;
+const int ScreenshotCapture::REANCHOR_MISSES;
 
 ScreenshotCapture::ScreenshotCapture(QObject *parent)
     : QObject(parent)
     , m_detectionTimer(nullptr)
     , m_primaryScreen(nullptr)
+    , m_captureScreen(nullptr)
+    , m_captureBackend(CaptureBackend::create())
     , m_isCapturing(false)
     , m_captureCount(0)
     , m_detectionInterval(DEFAULT_DETECTION_INTERVAL)
     , m_hashSampleStep(2)           // 默认采样步长
-    , m_maxCoveredRegions(200)      // 最大覆盖区域数量
+    , m_maxCoveredRegions(2000)     // 最大覆盖区域数量（按 Y 区间索引查找，数量多不影响去重速度）
     , m_lastCleanupTime(0)
     , m_duplicateSkipCount(0)
     , m_consecutiveDuplicates(0)
     , m_lastDuplicateTime(0)
+    , m_frameRing(FRAME_RING_CAPACITY)
+    , m_dedupQueue(PIPELINE_STAGE_CAPACITY)
+    , m_composeQueue(PIPELINE_STAGE_CAPACITY)
 {
     m_primaryScreen = QApplication::primaryScreen();
     
@@ -53,12 +70,417 @@ ScreenshotCapture::ScreenshotCapture(QObject *parent)
 ScreenshotCapture::~ScreenshotCapture()
 {
     stopScrollCapture();
+    delete m_captureBackend;
+    delete m_suspendedBackend;
 }
 
 void ScreenshotCapture::setCapturezone(const QRect& rect)
 {
+    // 截图线程只使用已绑定的后端，选区变化时先停下线程，在 GUI 线程重新绑定后再恢复
+    const bool restartThread = (m_captureThread != nullptr);
+    stopCaptureThread();
     m_captureRect = rect;
-    qDebug() << "设置截图区域:" << rect;
+    m_captureScreen = CaptureBackend::screenForRect(rect);
+    qDebug() << "设置截图区域:" << rect << "所在屏幕:" << (m_captureScreen ? m_captureScreen->name() : QString());
+    if (m_isCapturing) {
+        prepareCaptureBackend();
+    }
+    if (restartThread && m_isCapturing) {
+        startCaptureThread();
+    }
+}
+
+void ScreenshotCapture::setCaptureBackend(const QString& name)
+{
+    setCaptureBackend(CaptureBackend::create(name));
+}
+
+void ScreenshotCapture::setCaptureBackend(CaptureBackend* backend)
+{
+    if (!backend || backend == m_captureBackend) {
+        return;
+    }
+    // 截图线程正在使用旧后端，先停下再替换
+    const bool restartThread = (m_captureThread != nullptr);
+    stopCaptureThread();
+    delete m_captureBackend;
+    m_captureBackend = backend;
+    qDebug() << "截图后端:" << m_captureBackend->name();
+    if (m_isCapturing) {
+        prepareCaptureBackend();
+    }
+    if (restartThread && m_isCapturing) {
+        if (m_captureBackend->supportsThreadedGrab()) {
+            startCaptureThread();
+        } else {
+            // 新后端只能在 GUI 线程抓取：处理完已抓到的帧，改由检测定时器驱动
+            stopPipeline();
+            processStitchingQueue();
+            m_detectionTimer->start(nextDetectionDelay());
+        }
+    }
+}
+
+void ScreenshotCapture::setCaptureThreadEnabled(bool enabled)
+{
+    m_useCaptureThread = enabled;
+}
+
+void ScreenshotCapture::setPipelineEnabled(bool enabled)
+{
+    m_usePipeline = enabled;
+}
+
+void ScreenshotCapture::setAdaptiveCaptureEnabled(bool enabled)
+{
+    m_adaptiveCapture = enabled;
+}
+
+void ScreenshotCapture::setRegistrationEnabled(bool enabled)
+{
+    m_useRegistration = enabled;
+}
+
+void ScreenshotCapture::setCanvasMemoryBudget(int megabytes)
+{
+    m_canvasMemoryBudget = qint64(qMax(0, megabytes)) * 1024 * 1024;
+    m_canvas->setMemoryBudget(m_canvasMemoryBudget);
+}
+
+void ScreenshotCapture::setScrollMatcher(ScrollMatcher matcher)
+{
+    m_scrollMatcher = matcher;
+}
+
+void ScreenshotCapture::setScrollMatcher(const QString& name)
+{
+    if (name == QLatin1String("template")) {
+        setScrollMatcher(ScrollMatcher::Template);
+    } else if (name == QLatin1String("phase")) {
+        setScrollMatcher(ScrollMatcher::PhaseCorrelation);
+    } else {
+        if (!name.isEmpty() && name != QLatin1String("rows")) {
+            qDebug() << "未知的滚动位移估计方式:" << name << "，使用 rows";
+        }
+        setScrollMatcher(ScrollMatcher::RowSignature);
+    }
+    qDebug() << "滚动位移估计方式:" << scrollMatcherName();
+}
+
+QString ScreenshotCapture::scrollMatcherName() const
+{
+    switch (m_scrollMatcher) {
+    case ScrollMatcher::Template:
+        return QStringLiteral("template");
+    case ScrollMatcher::RowSignature:
+        return QStringLiteral("rows");
+    case ScrollMatcher::PhaseCorrelation:
+        return QStringLiteral("phase");
+    }
+    return QString();
+}
+
+void ScreenshotCapture::startCaptureThread()
+{
+    if (m_captureThread) {
+        return;
+    }
+    if (!m_detectThread) {
+        m_frameRing.clear();
+    }
+    m_captureThread = new QThread(this);
+    m_captureThread->setObjectName("RabbitShotCapture");
+    // 后端已在 GUI 线程绑定到选区，截图线程只调用 grab()，不读写选区、不重新绑定；
+    // 更换后端或选区时先停下本线程
+    m_captureWorker = new CaptureWorker(&m_frameRing, [this](qint64& timestampMs) {
+        const QImage frame = grabBoundFrame();
+        timestampMs = m_captureBackend->frameTimestampMs();
+        return frame;
+    });
+    m_captureWorker->moveToThread(m_captureThread);
+    if (m_detectThread) {
+        // 流水线模式：每帧直接唤醒检测线程，GUI 线程不参与取帧
+        m_captureWorker->setFrameCallback([this]() {
+            m_detectWakeup.notify();
+        });
+    } else {
+        connect(m_captureWorker, &CaptureWorker::frameAvailable,
+                this, &ScreenshotCapture::processStitchingQueue, Qt::QueuedConnection);
+    }
+    m_captureThread->start();
+    QMetaObject::invokeMethod(m_captureWorker, "start", Qt::QueuedConnection, Q_ARG(int, m_detectionInterval));
+    qDebug() << "🧵 截图线程已启动，队列容量:" << m_frameRing.capacity();
+}
+
+void ScreenshotCapture::stopCaptureThread()
+{
+    if (!m_captureThread) {
+        return;
+    }
+    // 在截图线程内停止定时器，然后退出事件循环
+    QMetaObject::invokeMethod(m_captureWorker, "stop", Qt::BlockingQueuedConnection);
+    m_captureThread->quit();
+    m_captureThread->wait();
+    qDebug() << "🧵 截图线程已停止，丢弃帧数:" << m_frameRing.droppedCount();
+    delete m_captureWorker;
+    m_captureWorker = nullptr;
+    delete m_captureThread;
+    m_captureThread = nullptr;
+}
+
+void ScreenshotCapture::startPipeline()
+{
+    if (m_detectThread) {
+        return;
+    }
+    m_frameRing.clear();
+    m_detectWakeup.reset();
+    m_dedupQueue.reset();
+    m_composeQueue.reset();
+
+    m_detectThread = QThread::create([this]() { runDetectStage(); });
+    m_dedupThread = QThread::create([this]() { runDedupStage(); });
+    m_composeThread = QThread::create([this]() { runComposeStage(); });
+    m_detectThread->setObjectName("RabbitShotDetect");
+    m_dedupThread->setObjectName("RabbitShotDedup");
+    m_composeThread->setObjectName("RabbitShotCompose");
+    m_composeThread->start();
+    m_dedupThread->start();
+    m_detectThread->start();
+    qDebug() << "🧵 拼接流水线已启动：检测 -> 去重 -> 合成";
+}
+
+void ScreenshotCapture::stopPipeline()
+{
+    if (!m_detectThread) {
+        return;
+    }
+    // 按阶段顺序关闭：上游退出前会处理完已取到的数据，下游再排空自己的队列
+    m_detectWakeup.close();
+    m_detectThread->wait();
+    m_dedupQueue.close();
+    m_dedupThread->wait();
+    m_composeQueue.close();
+    m_composeThread->wait();
+
+    // 执行合成线程已投递但尚未执行的提交，保证最后的片段进入结果
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+
+    delete m_detectThread;
+    delete m_dedupThread;
+    delete m_composeThread;
+    m_detectThread = nullptr;
+    m_dedupThread = nullptr;
+    m_composeThread = nullptr;
+    qDebug() << "🧵 拼接流水线已停止";
+}
+
+void ScreenshotCapture::runDetectStage()
+{
+    // 检测阶段：取出截图线程写入的帧，与上一帧做重叠检测并提取新内容
+    for (;;) {
+        const bool open = m_detectWakeup.wait();
+        CaptureTask task;
+        while (m_frameRing.tryPop(task)) {
+            if (isFrameUnchanged(task.screenshot, task.timestamp)) {
+                continue;
+            }
+            const FrameAnalysis currentFrame(task.screenshot, task.timestamp);
+            DetectedFrame detected;
+            if (!detectNewContent(currentFrame, detected)) {
+                continue;
+            }
+            detected.taskId = task.taskId;
+            detected.timestamp = task.timestamp;
+            // 参考帧随检测前移，不等待去重结果，检测才能与后续阶段并行
+            m_lastFrame = currentFrame;
+            if (!m_dedupQueue.push(detected)) {
+                return;
+            }
+        }
+        if (!open) {
+            return;
+        }
+    }
+}
+
+void ScreenshotCapture::runDedupStage()
+{
+    // 去重阶段：与已覆盖区域比较，确定新内容在长图中的逻辑位置
+    DetectedFrame detected;
+    while (m_dedupQueue.pop(detected)) {
+        GlobalContentRegion segment;
+        if (screenNewContent(detected, segment) && !m_composeQueue.push(segment)) {
+            return;
+        }
+    }
+}
+
+void ScreenshotCapture::runComposeStage()
+{
+    // 合成阶段：一次取出所有待合成片段，逐个拷贝进画布，再把预览图按顺序提交到 GUI 线程
+    QList<GlobalContentRegion> segments;
+    while (m_composeQueue.popAll(segments)) {
+        for (const GlobalContentRegion& segment : segments) {
+            m_canvas->blit(segment.image, segment.logicalRect.topLeft());
+        }
+        const QImage preview = m_canvas->preview();
+        QMetaObject::invokeMethod(this, [this, segments, preview]() {
+            commitComposedSegments(segments, preview);
+        }, Qt::QueuedConnection);
+    }
+}
+
+// 根据当前滚动速度计算下一次抓取间隔；变化不足 10% 时不调整，避免频繁重启定时器
+void ScreenshotCapture::scheduleNextCapture(int effectiveHeight)
+{
+    const int previous = m_captureScheduler.interval();
+    const int next = m_captureScheduler.update(m_motionModel.velocity(), effectiveHeight);
+    if (qAbs(next - previous) * 10 < previous) {
+        return;
+    }
+    qDebug() << "⏲ 调整抓取间隔:" << previous << "->" << next << "ms"
+             << "速度:" << QString::number(m_motionModel.velocity() * 1000.0, 'f', 0) << "像素/秒"
+             << (m_captureScheduler.isIdle() ? "(静止，慢速轮询)" : "");
+    requestCaptureInterval(next);
+}
+
+void ScreenshotCapture::requestCaptureInterval(int intervalMs)
+{
+    if (QThread::currentThread() == thread()) {
+        applyCaptureInterval(intervalMs);
+    } else {
+        // 检测线程不直接访问截图线程对象，交给 GUI 线程执行
+        QMetaObject::invokeMethod(this, [this, intervalMs]() {
+            applyCaptureInterval(intervalMs);
+        }, Qt::QueuedConnection);
+    }
+}
+
+// 检测之前的快速判断：抽样行哈希与上一次抓取完全相同则跳过整帧分析，
+// 连续不变时抓取间隔指数退避，画面变化后恢复。
+// 跳过的帧仍是一次 0 位移的测量，照常计入运动模型和静止判断，速度才不会停留在停下前的值
+bool ScreenshotCapture::isFrameUnchanged(const QImage& frame, qint64 timestampMs)
+{
+    const quint64 hash = FrameAnalysis::sampledRowsHash(frame);
+    const bool unchanged = (hash == m_lastGrabHash);
+    const qint64 previousGrabMs = m_lastGrabTimestampMs;
+    m_lastGrabHash = hash;
+    m_lastGrabTimestampMs = timestampMs;
+
+    if (unchanged) {
+        m_unchangedFrameCount++;
+        if (previousGrabMs >= 0 && timestampMs > previousGrabMs) {
+            m_motionModel.update(0, timestampMs - previousGrabMs);
+        }
+        const int previous = m_captureScheduler.interval();
+        const int next = m_captureScheduler.markUnchanged();
+        if (next != previous) {
+            qDebug() << "💤 画面未变化，抓取间隔退避:" << previous << "->" << next << "ms";
+            requestCaptureInterval(next);
+        }
+        return true;
+    }
+    if (m_captureScheduler.isBackedOff()) {
+        const int next = m_captureScheduler.wake();
+        qDebug() << "⏰ 画面恢复变化，抓取间隔恢复:" << next << "ms";
+        requestCaptureInterval(next);
+    }
+    return false;
+}
+
+void ScreenshotCapture::applyCaptureInterval(int intervalMs)
+{
+    // 回放按录制节奏推进，不参与调度
+    if (!m_isCapturing || isReplaying()) {
+        return;
+    }
+    if (m_captureWorker) {
+        m_captureWorker->setInterval(intervalMs);
+    } else if (m_detectionTimer->isActive()) {
+        m_detectionTimer->setInterval(intervalMs);
+    }
+}
+
+void ScreenshotCapture::commitComposedSegments(const QList<GlobalContentRegion>& segments, const QImage& preview)
+{
+    // 片段经单一 FIFO 通道到达，顺序与去重阶段分配的 order 一致；像素已在画布中，只保留位置信息
+    for (GlobalContentRegion segment : segments) {
+        segment.image = QImage();
+        m_globalRegions.append(segment);
+    }
+    m_previewImage = QPixmap::fromImage(preview);
+    emit newImageCaptured(m_previewImage);
+}
+
+QString ScreenshotCapture::captureBackendName() const
+{
+    return m_captureBackend ? m_captureBackend->name() : QString();
+}
+
+CaptureStats ScreenshotCapture::captureStats() const
+{
+    return m_captureBackend ? m_captureBackend->stats() : CaptureStats();
+}
+
+void ScreenshotCapture::setRecordingPath(const QString& path)
+{
+    m_recordingPath = path;
+}
+
+bool ScreenshotCapture::isReplaying() const
+{
+    return m_captureBackend && !m_captureBackend->isLive();
+}
+
+bool ScreenshotCapture::startReplay(const QString& path, bool realTime)
+{
+    if (m_isCapturing) {
+        return false;
+    }
+    
+    SessionReplayBackend* replay = new SessionReplayBackend();
+    if (!replay->open(path)) {
+        delete replay;
+        emit captureStatusChanged("错误：无法打开回放会话");
+        return false;
+    }
+    
+    // 暂存实时后端，回放结束后恢复
+    m_suspendedBackend = m_captureBackend;
+    m_captureBackend = replay;
+    m_replayRealTime = realTime;
+    m_captureRect = QRect(QPoint(0, 0), replay->frameSize());
+    m_captureScreen = nullptr;
+    m_replayClock.start();
+    
+    startScrollCapture();
+    if (!m_isCapturing) {
+        finishReplay();
+        return false;
+    }
+    return true;
+}
+
+void ScreenshotCapture::finishReplay()
+{
+    if (!m_suspendedBackend) {
+        return;
+    }
+    delete m_captureBackend;
+    m_captureBackend = m_suspendedBackend;
+    m_suspendedBackend = nullptr;
+    m_captureRect = QRect();
+}
+
+int ScreenshotCapture::nextDetectionDelay() const
+{
+    if (m_captureBackend && !m_captureBackend->isLive()) {
+        // 回放：尽快回放时间隔为 0，否则按录制时的帧间隔
+        const int delay = m_captureBackend->nextFrameDelayMs();
+        return (m_replayRealTime && delay >= 0) ? delay : 0;
+    }
+    return m_detectionInterval;
 }
 
 void ScreenshotCapture::startScrollCapture()
@@ -68,7 +490,11 @@ void ScreenshotCapture::startScrollCapture()
         return;
     }
     
-    if (!m_primaryScreen) {
+    const bool live = m_captureBackend->isLive();
+    if (live && !m_captureScreen) {
+        m_captureScreen = CaptureBackend::screenForRect(m_captureRect);
+    }
+    if (live && !m_captureScreen) {
         emit captureStatusChanged("错误：无法访问屏幕");
         return;
     }
@@ -77,8 +503,8 @@ void ScreenshotCapture::startScrollCapture()
     m_isCapturing = true;
     m_captureCount = 0;
     
-    // 测试截图权限
-    QPixmap testCapture = m_primaryScreen->grabWindow(0, 0, 0, 100, 100);
+    // 测试截图权限（回放不需要）
+    QPixmap testCapture = live ? m_captureScreen->grabWindow(0, 0, 0, 100, 100) : QPixmap(1, 1);
     
     if (testCapture.isNull()) {
         // 权限错误保留输出
@@ -96,9 +522,25 @@ void ScreenshotCapture::startScrollCapture()
         return;
     }
     
+    // 绑定截图后端到选区所在屏幕，之后每次只抓取选区像素
+    if (!prepareCaptureBackend()) {
+        emit captureStatusChanged("错误：截图区域不在任何屏幕内");
+        m_isCapturing = false;
+        return;
+    }
+    m_captureBackend->resetStats();
+    
+    // 按需录制本次会话（回放时不再录制）
+    if (live && !m_recordingPath.isEmpty()) {
+        m_recorder.open(m_recordingPath);
+    }
+    
     // 捕获初始图片作为基础
-    m_baseImage = captureRegion(m_captureRect);
-    m_lastScreenshot = m_baseImage;
+    const QImage baseFrame = captureRegion(m_captureRect);
+    m_lastFrame = FrameAnalysis(baseFrame, m_captureBackend->frameTimestampMs());
+    m_lastGrabHash = FrameAnalysis::sampledRowsHash(m_lastFrame.image());
+    m_lastGrabTimestampMs = m_lastFrame.timestampMs();
+    m_baseImage = QPixmap::fromImage(m_lastFrame.image());
     
     if (!m_baseImage.isNull()) {
         // 初始化基础图片的段信息
@@ -115,17 +557,22 @@ void ScreenshotCapture::startScrollCapture()
         
         // 将基础图片添加到全局区域
         QRect baseRect = QRect(0, 0, m_baseImage.width(), m_baseImage.height());
-        updateGlobalRegion(m_baseImage, baseRect);
+        updateGlobalRegion(m_lastFrame.image(), baseRect);
         
         // 将基础图片记录到已覆盖区域（重要：防止重复截取基础内容）
-        addToCoveredRegions(m_baseImage, baseRect, ScrollDirection::None, 0);
+        ContentSignature baseSignature;
+        baseSignature.fingerprint = m_lastFrame.rowsFingerprint(0, m_lastFrame.height());
+        baseSignature.perceptualHash = PerceptualHash::dHash(m_lastFrame.gray());
+        baseSignature.hasPerceptualHash = true;
+        addToCoveredRegions(m_lastFrame.image(), baseRect, ScrollDirection::None, 0, baseSignature);
         
         // 简单自动识别固定区域（顶部/底部单调色带等），以便在匹配时忽略
-        m_fixedRegions = detectFixedRegions(m_baseImage.toImage());
+        m_fixedRegions = detectFixedRegions(m_lastFrame);
         if (m_fixedRegions.hasTopRegion || m_fixedRegions.hasBottomRegion) {
             qDebug() << "🔒 检测到固定区域 - 顶部高:" << (m_fixedRegions.hasTopRegion ? m_fixedRegions.topRegion.height() : 0)
                      << " 底部高:" << (m_fixedRegions.hasBottomRegion ? m_fixedRegions.bottomRegion.height() : 0);
         }
+        resetRegistration(m_lastFrame);
         
         m_captureCount++;
         emit newImageCaptured(m_baseImage);
@@ -134,12 +581,27 @@ void ScreenshotCapture::startScrollCapture()
         // 输出关键的开始信息
         qDebug() << "📸 开始滚动截图 - 基础图片尺寸:" << m_baseImage.size() << "捕获区域:" << m_captureRect;
         
-        // 启动检测定时器
-        m_detectionTimer->start(m_detectionInterval);
+        // 实时截图按滚动速度调度抓取间隔；回放按录制节奏
+        m_captureScheduler.reset(m_detectionInterval);
+        m_scheduleActive = live && m_adaptiveCapture;
+        
+        // 实时截图默认在独立线程中抓取，并按阶段流水线处理；否则（或后端只能在 GUI 线程抓取时）启动检测定时器
+        if (live && m_useCaptureThread && !m_captureBackend->supportsThreadedGrab()) {
+            qDebug() << "截图后端" << m_captureBackend->name() << "只能在 GUI 线程抓取，不使用截图线程";
+        }
+        if (live && m_useCaptureThread && m_captureBackend->supportsThreadedGrab()) {
+            if (m_usePipeline) {
+                startPipeline();
+            }
+            startCaptureThread();
+        } else {
+            m_detectionTimer->start(nextDetectionDelay());
+        }
     } else {
         // 错误信息保留
         emit captureStatusChanged("无法捕获初始截图");
         m_isCapturing = false;
+        m_recorder.close();
     }
 }
 
@@ -149,8 +611,15 @@ void ScreenshotCapture::stopScrollCapture()
         return;
     }
     
+    // 先停止生产者，再把队列中剩余的帧处理完，避免丢失最后一次滚动的内容
+    stopCaptureThread();
+    stopPipeline();
+    processStitchingQueue();
+    m_scheduleActive = false;
+    
     m_isCapturing = false;
     m_detectionTimer->stop();
+    m_recorder.close();
     m_duplicateSkipCount = 0;
     
     // 重置连续重复计数器
@@ -162,17 +631,25 @@ void ScreenshotCapture::stopScrollCapture()
     // 输出性能指标
     logPerformanceMetrics();
     
-    // 合并所有图片
-    m_combinedImage = combineImages();
+    if (isReplaying()) {
+        const qint64 elapsedMs = qMax<qint64>(1, m_replayClock.elapsed());
+        const int frames = m_captureBackend->stats().grabCount;
+        qDebug() << "⏱ 回放完成 - 帧数:" << frames << "耗时:" << elapsedMs << "ms"
+                 << "吞吐:" << QString::number(frames * 1000.0 / elapsedMs, 'f', 1) << "帧/秒";
+        finishReplay();
+    }
+    
+    // 长图保留在分块画布中，这里只生成预览；需要完整图像时再按需取出
+    m_previewImage = createPreviewImage();
     
-    if (!m_combinedImage.isNull()) {
-        emit captureFinished(m_combinedImage);
+    if (!m_previewImage.isNull()) {
+        emit captureFinished(m_previewImage);
         
         // 打印拼接统计信息
         qDebug() << "🏁 截图结束统计:";
         qDebug() << "   总片段数:" << (m_newContents.size() + 1);
         qDebug() << "   跳过重复:" << m_duplicateSkipCount << "次";
-        qDebug() << "   最终长图尺寸:" << m_combinedImage.size();
+        qDebug() << "   最终长图尺寸:" << combinedImageSize() << "图块数:" << m_canvas->tileCount();
         qDebug() << "   Y轴总范围:" << m_globalBounds.height() << "像素";
         
         emit captureStatusChanged(QString("截图完成！总共 %1 个片段，跳过 %2 个重复")
@@ -182,19 +659,24 @@ void ScreenshotCapture::stopScrollCapture()
     }
 }
 
-QPixmap ScreenshotCapture::getCombinedImage() const
+QSharedPointer<StitchCanvas> ScreenshotCapture::canvas() const
 {
-    // 返回当前合成图（按需合成）
-    return combineImages();
+    return m_canvas;
 }
 
-QPixmap ScreenshotCapture::getCurrentCombinedImage() const
+QImage ScreenshotCapture::baseImage() const
 {
-    // 若已有缓存则返回，否则按需合成
-    if (!m_combinedImage.isNull()) {
-        return m_combinedImage;
-    }
-    return combineImages();
+    return m_baseImage.toImage();
+}
+
+QPixmap ScreenshotCapture::getPreviewImage() const
+{
+    return m_previewImage.isNull() ? m_baseImage : m_previewImage;
+}
+
+QSize ScreenshotCapture::combinedImageSize() const
+{
+    return m_canvas->isEmpty() ? m_baseImage.size() : m_canvas->bounds().size();
 }
 
 void ScreenshotCapture::setDetectionInterval(int interval)
@@ -204,6 +686,9 @@ void ScreenshotCapture::setDetectionInterval(int interval)
     if (m_detectionTimer) {
         m_detectionTimer->setInterval(m_detectionInterval);
     }
+    if (m_captureWorker) {
+        m_captureWorker->setInterval(m_detectionInterval);
+    }
 }
 
 QList<QPixmap> ScreenshotCapture::getCapturedImages() const
@@ -221,9 +706,17 @@ void ScreenshotCapture::clearCapturedImages()
     m_newContents.clear();
     m_segments.clear();
     m_globalRegions.clear();
+    // 不原地清空：后台导出可能仍在读取上一张长图，换用新画布，旧画布随最后一个引用释放
+    m_canvas = QSharedPointer<StitchCanvas>::create();
+    m_canvas->setMemoryBudget(m_canvasMemoryBudget);
+    m_regionOrder = 0;
     m_coveredRegions.clear();  // 清理已覆盖区域
-    m_combinedImage = QPixmap();
-    m_lastScreenshot = QPixmap();
+    m_coveredHashIndex.clear();
+    m_coveredYIndex.clear();
+    m_nextCoveredRegionId = 0;
+    m_hashIndexHitCount = 0;
+    m_previewImage = QPixmap();
+    m_lastFrame = FrameAnalysis();
     m_baseImage = QPixmap();
     m_captureCount = 0;
     m_globalBounds = QRect();
@@ -232,6 +725,25 @@ void ScreenshotCapture::clearCapturedImages()
     m_consecutiveDuplicates = 0;  // 重置连续重复计数器
     m_lastDuplicateTime = 0;   // 重置最后重复时间
     m_lastCleanupTime = 0;
+    m_rowMatchCount = 0;
+    m_rowMatchFallbackCount = 0;
+    m_pyramidMatchCount = 0;
+    m_pyramidFallbackCount = 0;
+    m_motionHitCount = 0;
+    m_motionMissCount = 0;
+    m_motionModel.reset();
+    m_lastGrabHash = 0;
+    m_lastGrabTimestampMs = -1;
+    m_unchangedFrameCount = 0;
+    m_viewportY = 0;
+    m_canvasTop = 0;
+    m_canvasBottom = 0;
+    m_registeredAppendCount = 0;
+    m_registeredCoveredCount = 0;
+    m_registrationMisses = 0;
+    m_canvasIndex.reset();
+    m_reanchorCount = 0;
+    m_reanchorFailCount = 0;
 }
 
 // removed duplicate setDetectionInterval(int) implementation; unified in the earlier definition.
@@ -254,353 +766,764 @@ void ScreenshotCapture::onScrollDetectionTimer()
     }
 
     // 捕获当前屏幕区域
-    QPixmap currentScreenshot = captureRegion(m_captureRect);
+    QImage currentScreenshot = captureRegion(m_captureRect);
     if (currentScreenshot.isNull()) {
+        if (isReplaying() && m_captureBackend->atEnd()) {
+            // 回放帧已全部处理，按正常结束流程输出结果
+            stopScrollCapture();
+        }
+        return;
+    }
+    if (isReplaying()) {
+        m_detectionTimer->setInterval(nextDetectionDelay());
+    }
+
+    processCapturedFrame(currentScreenshot, m_captureBackend->frameTimestampMs());
+}
+
+// timestampMs 为抓取（回放时为录制）时刻，而不是处理时刻，回放结果因此不受处理速度影响
+void ScreenshotCapture::processCapturedFrame(const QImage& currentScreenshot, qint64 timestampMs)
+{
+    if (currentScreenshot.isNull() || isFrameUnchanged(currentScreenshot, timestampMs)) {
+        return;
+    }
+
+    // 每帧只分析一次，检测、去重和下一帧的比较都使用同一份结果
+    const FrameAnalysis currentFrame(currentScreenshot, timestampMs);
+    DetectedFrame detected;
+    if (!detectNewContent(currentFrame, detected)) {
         return;
     }
+    // 参考帧的前移规则与流水线检测阶段一致：检测到新内容即前移，不取决于去重结果，
+    // 实时截图（流水线）与回放（本路径）对同一组帧得到相同的拼接结果
+    m_lastFrame = currentFrame;
+
+    GlobalContentRegion segment;
+    if (screenNewContent(detected, segment)) {
+        appendGlobalRegion(segment);
+        
+        // 发出新预览信号（同时缓存，预览窗口再次获取时不必重新生成）
+        m_previewImage = createPreviewImage();
+        emit newImageCaptured(m_previewImage);
+    }
+}
+
+bool ScreenshotCapture::detectNewContent(const FrameAnalysis& currentFrame, DetectedFrame& detected)
+{
+    if (currentFrame.isNull() || m_lastFrame.isNull()) {
+        return false;
+    }
+    if (m_useRegistration) {
+        return registerNewContent(currentFrame, detected);
+    }
 
     // 检测滚动
-    ScrollInfo scrollInfo = detectScroll(m_lastScreenshot.toImage(), currentScreenshot.toImage());
-    
-    if (scrollInfo.hasScroll) {
-        emit scrollDetected(scrollInfo.direction, scrollInfo.offset);
-        // 验证新内容是否有效
-        if (scrollInfo.newContentRect.height() < MIN_NEW_CONTENT_HEIGHT) {
-            qDebug() << "新内容高度过小，跳过此次捕获：" << scrollInfo.newContentRect.height();
-            return;
-        }
+    ScrollInfo scrollInfo = detectScroll(m_lastFrame, currentFrame);
+    if (!scrollInfo.hasScroll) {
+        return false;
+    }
+    emit scrollDetected(scrollInfo.direction, scrollInfo.offset);
 
-        // 提取新内容
-        QImage newContent = extractNewContent(currentScreenshot.toImage(), scrollInfo);
+    // 验证新内容是否有效
+    if (scrollInfo.newContentRect.height() < MIN_NEW_CONTENT_HEIGHT) {
+        qDebug() << "新内容高度过小，跳过此次捕获：" << scrollInfo.newContentRect.height();
+        return false;
+    }
 
-        // 计算逻辑区域位置（基于滚动方向）
-        QRect logicalRect;
-        if (scrollInfo.direction == ScrollDirection::Down) {
-            logicalRect = QRect(0, m_currentScrollPos, newContent.width(), newContent.height());
-        } else if (scrollInfo.direction == ScrollDirection::Up) {
-            int currentMinY = m_globalBounds.isEmpty() ? 0 : m_globalBounds.top();
-            logicalRect = QRect(0, currentMinY - newContent.height(), newContent.width(), newContent.height());
+    // 提取新内容
+    detected.scrollInfo = scrollInfo;
+    detected.newContent = extractNewContent(currentFrame.image(), scrollInfo);
+    fillContentSignature(currentFrame, scrollInfo.newContentRect, detected.signature);
+    return !detected.newContent.isNull();
+}
+
+void ScreenshotCapture::fillContentSignature(const FrameAnalysis& frame, const QRect& rows, ContentSignature& signature)
+{
+    signature.fingerprint = frame.rowsFingerprint(rows.y(), rows.height());
+    // 感知哈希直接取灰度平面中新内容对应的行，不需要再转换新内容图像
+    const QRect hashRect = rows.intersected(QRect(0, 0, frame.width(), frame.height()));
+    if (!hashRect.isEmpty()) {
+        const cv::Mat gray = frame.gray()(cv::Rect(hashRect.x(), hashRect.y(), hashRect.width(), hashRect.height()));
+        signature.perceptualHash = PerceptualHash::dHash(gray);
+        signature.hasPerceptualHash = true;
+    }
+}
+
+// 以基础帧建立配准坐标：基础帧覆盖 [有效区域顶部, 有效区域底部)，顶部、底部固定区域（标题栏、状态栏等）会被后续追加的内容覆盖
+void ScreenshotCapture::resetRegistration(const FrameAnalysis& baseFrame)
+{
+    int top = 0;
+    int effHeight = 0;
+    effectiveRowRange(baseFrame.height(), top, effHeight);
+    // 基础帧的固定头部 [0, top) 不是滚动内容，不计入已覆盖范围：向上滚动的新内容从 top 之上追加，覆盖掉头部
+    m_viewportY = 0;
+    m_canvasTop = top;
+    m_canvasBottom = top + qMax(0, effHeight);
+    m_registrationMisses = 0;
+    m_canvasIndex.reset();
+    // 索引约为长图 RGBA 的 1/16，按同样比例从长图的内存预算中分配
+    m_canvasIndex.setMemoryBudget(m_canvasMemoryBudget / 16);
+    if (m_canvasBottom > m_canvasTop) {
+        m_canvasIndex.addRows(m_canvasTop, baseFrame.gray().rowRange(m_canvasTop, m_canvasBottom));
+    }
+}
+
+// 位置配准：上一帧在长图中的位置已知，与它的位移即给出当前帧的绝对 Y。
+// 当前帧有效区域对应的逻辑行中，只有落在 [m_canvasTop, m_canvasBottom) 之外的部分才是新内容，
+// 回滚、停顿、来回滚动时都只是一次区间比较，不需要再与已有内容比较相似度。
+// 与上一帧连续 REANCHOR_MISSES 次无法配准（快速甩动超出重叠范围、动画等）时，在整张长图中重新定位。
+bool ScreenshotCapture::registerNewContent(const FrameAnalysis& currentFrame, DetectedFrame& detected)
+{
+    if (m_lastFrame.image().size() != currentFrame.image().size()) {
+        return false;
+    }
+    int effTop = 0;
+    int effHeight = 0;
+    if (!effectiveRowRange(currentFrame.height(), effTop, effHeight)) {
+        return false;
+    }
+
+    const DisplacementEstimate estimate = estimateDisplacement(m_lastFrame, currentFrame);
+    const bool registered = estimate.isValid && estimate.confidence > SIMILARITY_THRESHOLD
+                            && effHeight - qAbs(estimate.displacement) >= MIN_OVERLAP_HEIGHT;
+    if (registered) {
+        m_viewportY += estimate.displacement;
+    } else {
+        // 参考帧保持不变：用户滚回原处时仍可直接配准
+        ++m_registrationMisses;
+        if (m_registrationMisses % REANCHOR_MISSES != 0 || !reanchorFrame(currentFrame, effTop, effHeight)) {
+            return false;
         }
+    }
 
-        // 使用改进的重复检测系统
-        if (!isContentAlreadyCovered(QPixmap::fromImage(newContent), logicalRect)) {
-            // 添加新内容到全局区域
-            addNewContent(newContent, scrollInfo);
-            
-            // 更新最后截图（仅在成功添加内容后）
-            m_lastScreenshot = currentScreenshot;
-            
-            // 发出新图片信号
-            emit newImageCaptured(getCombinedImage());
-        } else {
-            qDebug() << "❌ 跳过重复内容 - 位置:" << logicalRect << "方向:" << (scrollInfo.direction == ScrollDirection::Down ? "↓" : "↑");
+    // 配准成功：参考帧与视口位置一起前移（即使没有新行，也保证下一帧与最近的画面比较）
+    m_registrationMisses = 0;
+    m_lastFrame = currentFrame;
+
+    // 长图至少和一帧一样高，当前帧只可能从一侧超出已覆盖范围
+    const int frameTop = m_viewportY + effTop;          // 当前帧有效区域的逻辑范围
+    const int frameBottom = frameTop + effHeight;
+    int newTop = 0;
+    int newBottom = 0;
+    ScrollDirection direction = ScrollDirection::None;
+    if (frameBottom > m_canvasBottom) {
+        direction = ScrollDirection::Down;
+        newTop = qMax(m_canvasBottom, frameTop);
+        newBottom = frameBottom;
+    } else if (frameTop < m_canvasTop) {
+        direction = ScrollDirection::Up;
+        newTop = frameTop;
+        newBottom = qMin(m_canvasTop, frameBottom);
+    } else {
+        if (registered && estimate.displacement != 0) {
+            m_registeredCoveredCount++;
+        }
+        return false;
+    }
+
+    // 新行太少时不推进长图边界，留到下一帧与更多新行一起追加，不会丢行
+    if (newBottom - newTop < MIN_NEW_CONTENT_HEIGHT) {
+        return false;
+    }
+
+    ScrollInfo scrollInfo;
+    scrollInfo.hasScroll = true;
+    scrollInfo.direction = direction;
+    scrollInfo.offset = registered ? qAbs(estimate.displacement) : newBottom - newTop;
+    scrollInfo.newContentRect = QRect(0, newTop - m_viewportY, currentFrame.width(), newBottom - newTop);
+    if (direction == ScrollDirection::Down) {
+        scrollInfo.overlapRect = QRect(0, effTop, currentFrame.width(), scrollInfo.newContentRect.y() - effTop);
+    } else {
+        const int overlapTop = scrollInfo.newContentRect.y() + scrollInfo.newContentRect.height();
+        scrollInfo.overlapRect = QRect(0, overlapTop, currentFrame.width(), effTop + effHeight - overlapTop);
+    }
+    emit scrollDetected(scrollInfo.direction, scrollInfo.offset);
+
+    detected.scrollInfo = scrollInfo;
+    detected.newContent = extractNewContent(currentFrame.image(), scrollInfo);
+    if (detected.newContent.isNull()) {
+        return false;
+    }
+    detected.logicalRect = QRect(0, newTop, currentFrame.width(), newBottom - newTop);
+    fillContentSignature(currentFrame, scrollInfo.newContentRect, detected.signature);
+
+    if (direction == ScrollDirection::Down) {
+        m_canvasBottom = newBottom;
+    } else {
+        m_canvasTop = newTop;
+    }
+    m_canvasIndex.addRows(newTop, currentFrame.gray().rowRange(scrollInfo.newContentRect.y(),
+                                                               scrollInfo.newContentRect.y() + scrollInfo.newContentRect.height()));
+    m_registeredAppendCount++;
+    qDebug() << "📍 配准: 位移" << (registered ? estimate.displacement : 0) << "视口Y" << m_viewportY << "追加" << detected.logicalRect
+             << "长图范围" << m_canvasTop << "~" << m_canvasBottom;
+    return true;
+}
+
+// 重新定位：用当前帧有效区域的上、下三分之一分别在整张长图的缩小索引中搜索
+// （快速甩动后画面可能有一部分已超出长图，只要另一部分仍在长图内就能找回位置）。
+// 只接受明显优于其它位置的匹配，重复的列表项、表格行等有多个相近峰值时拒绝重新定位
+bool ScreenshotCapture::reanchorFrame(const FrameAnalysis& currentFrame, int effTop, int effHeight)
+{
+    const int bandHeight = effHeight / 3;
+    double bestScore = 0.0;
+    int bestViewport = 0;
+    for (const int bandOffset : {0, effHeight - bandHeight}) {
+        const cv::Mat band = currentFrame.gray().rowRange(effTop + bandOffset, effTop + bandOffset + bandHeight);
+        // 单调色块（空白区域）在哪里都能匹配上，不能用于定位
+        cv::Scalar mean;
+        cv::Scalar stddev;
+        cv::meanStdDev(band, mean, stddev);
+        if (stddev[0] < REANCHOR_MIN_STDDEV) {
+            continue;
+        }
+        int logicalY = 0;
+        double score = 0.0;
+        double margin = 0.0;
+        if (!m_canvasIndex.locate(band, logicalY, score, margin)) {
+            continue;
+        }
+        // 长图中有多处相似内容时全局最高峰不可信，宁可不定位，也不把新内容贴到错误的位置
+        if (margin < REANCHOR_MIN_MARGIN) {
+            qDebug() << "🧭 重新定位: 候选位置不唯一，忽略" << "得分" << score << "领先次高峰" << margin;
+            continue;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            bestViewport = logicalY - effTop - bandOffset;
         }
     }
+
+    if (bestScore < REANCHOR_MIN_SCORE) {
+        m_reanchorFailCount++;
+        qDebug() << "🧭 重新定位失败: 连续未配准" << m_registrationMisses << "次，最佳得分" << bestScore;
+        return false;
+    }
+
+    qDebug() << "🧭 重新定位: 连续未配准" << m_registrationMisses << "次后在长图中找回位置"
+             << "视口Y" << m_viewportY << "->" << bestViewport << "得分" << bestScore;
+    m_viewportY = bestViewport;
+    // 跟丢期间的速度已不可信，从新的位置重新估计
+    m_motionModel.reset();
+    m_reanchorCount++;
+    return true;
+}
+
+bool ScreenshotCapture::screenNewContent(const DetectedFrame& detected, GlobalContentRegion& segment)
+{
+    const QImage& newContent = detected.newContent;
+    const ScrollInfo& scrollInfo = detected.scrollInfo;
+
+    // 配准模式下位置已确定，新行不可能与已有内容重复
+    if (!detected.logicalRect.isEmpty()) {
+        return placeNewContent(newContent, scrollInfo, detected.signature, segment, detected.logicalRect);
+    }
+
+    // 计算逻辑区域位置（基于滚动方向）
+    QRect logicalRect;
+    if (scrollInfo.direction == ScrollDirection::Down) {
+        logicalRect = QRect(0, m_currentScrollPos, newContent.width(), newContent.height());
+    } else if (scrollInfo.direction == ScrollDirection::Up) {
+        int currentMinY = m_globalBounds.isEmpty() ? 0 : m_globalBounds.top();
+        logicalRect = QRect(0, currentMinY - newContent.height(), newContent.width(), newContent.height());
+    }
+
+    // 使用改进的重复检测系统
+    if (isContentAlreadyCovered(newContent, logicalRect, detected.signature)) {
+        qDebug() << "❌ 跳过重复内容 - 位置:" << logicalRect << "方向:" << (scrollInfo.direction == ScrollDirection::Down ? "↓" : "↑");
+        return false;
+    }
+    return placeNewContent(newContent, scrollInfo, detected.signature, segment);
 }
 
-QPixmap ScreenshotCapture::captureRegion(const QRect& rect)
+bool ScreenshotCapture::prepareCaptureBackend()
 {
-    if (!m_primaryScreen || rect.isEmpty()) {
-        // 只保留错误信息
-        return QPixmap();
+    if (m_captureBackend && !m_captureBackend->isLive()) {
+        // 离线源：选区即录制帧的完整尺寸
+        return m_captureBackend->prepare(m_captureScreen, m_captureRect);
+    }
+    if (!m_captureBackend || !m_captureScreen) {
+        return false;
     }
-    
-    double devicePixelRatio = m_primaryScreen->devicePixelRatio();
-    
-    QRect screenGeometry = m_primaryScreen->geometry();
-    
     // 调整截图区域，向内缩小4个像素以避开红色边框（边框宽度2px+余量）
-    QRect adjustedRect = rect.adjusted(4, 4, -4, -4);
+    QRect adjustedRect = m_captureRect.adjusted(4, 4, -4, -4);
     
     // 确保截图区域在屏幕范围内
-    QRect validRect = adjustedRect.intersected(screenGeometry);
+    QRect validRect = adjustedRect.intersected(m_captureScreen->geometry());
     if (validRect.isEmpty()) {
-        // 错误信息保留
-        return QPixmap();
+        return false;
     }
     
-    // 截取全屏
-    QPixmap fullScreen = m_primaryScreen->grabWindow(0);
-    if (fullScreen.isNull()) {
-        // 错误信息保留
-        return QPixmap();
+    if (!m_captureBackend->prepare(m_captureScreen, validRect)) {
+        qDebug() << "❌ 截图后端初始化失败:" << m_captureBackend->name() << "区域:" << validRect;
+        return false;
     }
-    
-    // 高DPI支持
-    QRect finalRect;
-    if (devicePixelRatio > 1.0) {
-        finalRect = QRect(
-            static_cast<int>(validRect.x() * devicePixelRatio),
-            static_cast<int>(validRect.y() * devicePixelRatio),
-            static_cast<int>(validRect.width() * devicePixelRatio),
-            static_cast<int>(validRect.height() * devicePixelRatio)
-        );
-    } else {
-        finalRect = validRect;
+    qDebug() << "📷 截图后端:" << m_captureBackend->name() << "屏幕:" << m_captureScreen->name()
+             << "设备像素区域:" << m_captureBackend->deviceRect();
+    return true;
+}
+
+QImage ScreenshotCapture::captureRegion(const QRect& rect)
+{
+    if (!m_captureBackend || rect.isEmpty()) {
+        // 只保留错误信息
+        return QImage();
     }
     
-    // 确保最终区域有效
-    if (finalRect.x() < 0 || finalRect.y() < 0 || 
-        finalRect.right() >= fullScreen.width() || 
-        finalRect.bottom() >= fullScreen.height() ||
-        finalRect.isEmpty()) {
-        // 错误信息保留
-        return QPixmap();
+    // 选区变化（或尚未绑定）时重新绑定后端
+    if (m_captureBackend->logicalRect().isEmpty() || rect != m_captureRect) {
+        m_captureRect = rect;
+        m_captureScreen = CaptureBackend::screenForRect(rect);
+        if (!prepareCaptureBackend()) {
+            return QImage();
+        }
+    }
+    return grabBoundFrame();
+}
+
+// 用已绑定的后端抓取一帧（不检查、不修改选区），截图线程只调用这里
+QImage ScreenshotCapture::grabBoundFrame()
+{
+    // 只抓取选区对应的设备像素
+    QImage result = m_captureBackend->grab();
+    if (m_recorder.isOpen() && !result.isNull()) {
+        m_recorder.addFrame(result);
     }
-    
-    QPixmap result = fullScreen.copy(finalRect);
     
     // 只在截图失败时输出错误信息
     if (result.isNull()) {
-        qDebug() << "❌ 截图失败 - 区域:" << finalRect << "全屏尺寸:" << fullScreen.size();
+        qDebug() << "❌ 截图失败 - 后端:" << m_captureBackend->name() << "区域:" << m_captureBackend->deviceRect();
     }
     
     return result;
 }
 
-ScrollInfo ScreenshotCapture::detectScroll(const QImage& lastImg, const QImage& newImg) {
+ScrollInfo ScreenshotCapture::detectScroll(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame) {
     ScrollInfo info;
     info.hasScroll = false;
 
-    if (lastImg.isNull() || newImg.isNull() || lastImg.size() != newImg.size()) {
+    if (lastFrame.isNull() || newFrame.isNull() || lastFrame.image().size() != newFrame.image().size()) {
         return info;
     }
+    const QImage& newImg = newFrame.image();
 
-    OverlapResult downResult = findOverlapRegion(lastImg, newImg, ScrollDirection::Down);
-    OverlapResult upResult = findOverlapRegion(lastImg, newImg, ScrollDirection::Up);
+    // 单次搜索同时得到方向与距离，位移为 0 表示画面没有滚动
+    const DisplacementEstimate estimate = estimateDisplacement(lastFrame, newFrame);
+    if (!estimate.isValid || estimate.confidence <= SIMILARITY_THRESHOLD || estimate.displacement == 0) {
+        return info;
+    }
 
-    // 选择相似度更高、且满足最小滚动距离的那个作为滚动方向
-    bool downIsValid = downResult.similarity > SIMILARITY_THRESHOLD && downResult.rect.height() >= MIN_SCROLL_DISTANCE;
-    bool upIsValid = upResult.similarity > SIMILARITY_THRESHOLD && upResult.rect.height() >= MIN_SCROLL_DISTANCE;
+    // 重叠高度 = 有效高度 - |位移|，与按方向分别匹配时的计算方式一致；
+    // 相位相关直接给出完整位移，不受重叠搜索高度的上限约束
+    const int maxOverlap = (m_scrollMatcher == ScrollMatcher::PhaseCorrelation) ? estimate.effectiveHeight : OVERLAP_SEARCH_HEIGHT;
+    const int overlapHeight = std::min(estimate.effectiveHeight - qAbs(estimate.displacement), maxOverlap);
+    if (overlapHeight < MIN_OVERLAP_HEIGHT || overlapHeight < MIN_SCROLL_DISTANCE) {
+        return info;
+    }
 
-    if (downIsValid && (!upIsValid || downResult.similarity > upResult.similarity)) {
+    info.offset = overlapHeight;  // 重叠高度
+    info.hasScroll = true;
+    if (estimate.displacement > 0) {
         info.direction = ScrollDirection::Down;
-        info.offset = downResult.rect.height();  // 重叠高度
-        info.hasScroll = true;
         
         // 向下滚动：新截图的顶部是重叠区域，底部是新内容
         info.overlapRect = QRect(0, 0, newImg.width(), info.offset);                 // 新图中的重叠部分（顶部）
         info.newContentRect = QRect(0, info.offset, newImg.width(), newImg.height() - info.offset); // 新图中的新内容（底部）
         
-        qDebug() << "检测到向下滚动，相似度：" << downResult.similarity << "滚动距离：" << info.offset;
-    } else if (upIsValid && (!downIsValid || upResult.similarity > downResult.similarity)) {
+        qDebug() << "检测到向下滚动，相似度：" << estimate.confidence << "滚动距离：" << info.offset;
+    } else {
         info.direction = ScrollDirection::Up;
-        info.offset = upResult.rect.height();  // 重叠高度
-        info.hasScroll = true;
         
         // 向上滚动：新截图的底部是重叠区域，顶部是新内容
         info.overlapRect = QRect(0, newImg.height() - info.offset, newImg.width(), info.offset); // 新图中的重叠部分（底部）
         info.newContentRect = QRect(0, 0, newImg.width(), newImg.height() - info.offset);        // 新图中的新内容（顶部）
         
-        qDebug() << "检测到向上滚动，相似度：" << upResult.similarity << "滚动距离：" << info.offset;
+        qDebug() << "检测到向上滚动，相似度：" << estimate.confidence << "滚动距离：" << info.offset;
     }
 
     return info;
 }
 
-double ScreenshotCapture::calculateImageSimilarity(const QImage& img1, const QImage& img2, const QRect& rect)
+// 按固定区域裁剪出参与匹配的有效行范围；有效高度过小时返回 false
+bool ScreenshotCapture::effectiveRowRange(int frameHeight, int& top, int& height) const
 {
-    if (img1.size() != img2.size() || rect.isEmpty()) {
-        return 0.0;
-    }
-    
-    QRect validRect = rect.intersected(QRect(0, 0, img1.width(), img1.height()));
-    if (validRect.isEmpty()) {
-        return 0.0;
+    const int topCrop = (m_fixedRegions.hasTopRegion ? m_fixedRegions.topRegion.height() : 0);
+    const int bottomCrop = (m_fixedRegions.hasBottomRegion ? m_fixedRegions.bottomRegion.height() : 0);
+    top = topCrop;
+    height = frameHeight - topCrop - bottomCrop;
+    return height >= MIN_OVERLAP_HEIGHT + 5;
+}
+
+// 按当前选择的方式估计带符号位移
+DisplacementEstimate ScreenshotCapture::estimateDisplacement(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame)
+{
+    if (lastFrame.isNull() || newFrame.isNull() || lastFrame.image().size() != newFrame.image().size()) {
+        return DisplacementEstimate();
     }
-    
-    int totalPixels = validRect.width() * validRect.height();
-    int similarPixels = 0;
-    
-    for (int y = validRect.top(); y <= validRect.bottom(); y += 2) { // 采样优化
-        for (int x = validRect.left(); x <= validRect.right(); x += 2) {
-            QRgb pixel1 = img1.pixel(x, y);
-            QRgb pixel2 = img2.pixel(x, y);
-            
-            // 计算RGB差异
-            int rDiff = abs(qRed(pixel1) - qRed(pixel2));
-            int gDiff = abs(qGreen(pixel1) - qGreen(pixel2));
-            int bDiff = abs(qBlue(pixel1) - qBlue(pixel2));
-            
-            // 如果差异很小，认为是相似的
-            if (rDiff + gDiff + bDiff < 30) {
-                similarPixels++;
+
+    DisplacementEstimate estimate;
+    if (m_scrollMatcher == ScrollMatcher::PhaseCorrelation) {
+        estimate = estimateDisplacementByPhase(lastFrame, newFrame);
+    } else {
+        if (m_scrollMatcher == ScrollMatcher::RowSignature) {
+            estimate = estimateDisplacementByRows(lastFrame, newFrame);
+            if (estimate.isValid) {
+                m_rowMatchCount++;
+            } else {
+                m_rowMatchFallbackCount++;
             }
         }
+        if (!estimate.isValid) {
+            estimate = estimateDisplacementByTemplate(lastFrame, newFrame);
+        }
     }
-    
-    return double(similarPixels) / (totalPixels / 4); // 采样了1/4的像素
+
+    // 每次可靠的测量（包括静止时的 0 位移）都用于更新运动模型，并据此安排下一次抓取；
+    // 画面已变化（未变化的帧在检测前就被跳过）却匹配失败时，说明抓取间隔太长，立即恢复最短间隔
+    if (estimate.isValid) {
+        m_motionModel.update(estimate.displacement, newFrame.timestampMs() - lastFrame.timestampMs());
+        if (m_scheduleActive) {
+            scheduleNextCapture(estimate.effectiveHeight);
+        }
+    } else if (m_scheduleActive) {
+        const int previous = m_captureScheduler.interval();
+        const int next = m_captureScheduler.markLost();
+        if (next != previous) {
+            qDebug() << "🔍 画面变化但未能匹配，抓取间隔恢复:" << previous << "->" << next << "ms";
+            requestCaptureInterval(next);
+        }
+    }
+    return estimate;
 }
 
-double ScreenshotCapture::calculateImageSimilarity(const QImage& img1, const QImage& img2, const QRect& rect1, const QRect& rect2)
+// 行签名一维对齐：纵向滚动只是整行平移，用行哈希投票即可得到位移，代价 O(H)。
+// 上一帧中只出现一次的行哈希建立索引，新帧每行查表为对应位移投一票；
+// 票数最多的位移再用重叠区域内逐行哈希一致的比例做校验。
+// 票数不足、次优位移票数接近或校验不通过时返回无效结果，由调用方回退到模板匹配。
+DisplacementEstimate ScreenshotCapture::estimateDisplacementByRows(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame)
 {
-    if (img1.isNull() || img2.isNull() || rect1.isEmpty() || rect2.isEmpty()) {
-        return 0.0;
+    DisplacementEstimate estimate;
+    int top = 0;
+    int effHeight = 0;
+    if (!effectiveRowRange(newFrame.height(), top, effHeight)) {
+        return estimate;
+    }
+
+    const QVector<quint64>& lastHashes = lastFrame.rowHashes();
+    const QVector<quint64>& newHashes = newFrame.rowHashes();
+
+    // 上一帧的行哈希 -> 行号；重复出现的行（空白、分隔线）标记为 -1，不参与投票
+    QHash<quint64, int> lastRows;
+    lastRows.reserve(effHeight);
+    for (int y = 0; y < effHeight; ++y) {
+        auto it = lastRows.find(lastHashes[top + y]);
+        if (it == lastRows.end()) {
+            lastRows.insert(lastHashes[top + y], y);
+        } else {
+            it.value() = -1;
+        }
     }
-    
-    // 确保两个区域尺寸相同
-    if (rect1.size() != rect2.size()) {
-        return 0.0;
+
+    // 位移 d 的票数存放在 votes[d + effHeight]
+    std::vector<int> votes(size_t(effHeight) * 2 + 1, 0);
+    for (int y = 0; y < effHeight; ++y) {
+        const int lastY = lastRows.value(newHashes[top + y], -1);
+        if (lastY >= 0) {
+            votes[size_t(lastY - y + effHeight)]++;
+        }
     }
-    
-    // 确保区域在图像范围内
-    QRect validRect1 = rect1.intersected(QRect(0, 0, img1.width(), img1.height()));
-    QRect validRect2 = rect2.intersected(QRect(0, 0, img2.width(), img2.height()));
-    
-    if (validRect1.isEmpty() || validRect2.isEmpty() || validRect1.size() != validRect2.size()) {
-        return 0.0;
+
+    int bestIndex = 0;
+    int bestVotes = 0;
+    int secondVotes = 0;
+    for (size_t i = 0; i < votes.size(); ++i) {
+        if (votes[i] > bestVotes) {
+            secondVotes = bestVotes;
+            bestVotes = votes[i];
+            bestIndex = int(i);
+        } else if (votes[i] > secondVotes) {
+            secondVotes = votes[i];
+        }
     }
-    
-    int totalPixels = validRect1.width() * validRect1.height();
-    int similarPixels = 0;
-    
-    // 比较两个区域的像素
-    for (int y = 0; y < validRect1.height(); y += 2) { // 采样优化
-        for (int x = 0; x < validRect1.width(); x += 2) {
-            QRgb pixel1 = img1.pixel(validRect1.x() + x, validRect1.y() + y);
-            QRgb pixel2 = img2.pixel(validRect2.x() + x, validRect2.y() + y);
-            
-            // 计算RGB差异
-            int rDiff = abs(qRed(pixel1) - qRed(pixel2));
-            int gDiff = abs(qGreen(pixel1) - qGreen(pixel2));
-            int bDiff = abs(qBlue(pixel1) - qBlue(pixel2));
-            
-            // 如果差异很小，认为是相似的
-            if (rDiff + gDiff + bDiff < 30) {
-                similarPixels++;
-            }
+    if (bestVotes < ROW_SIGNATURE_MIN_VOTES || bestVotes < secondVotes * 2) {
+        return estimate;
+    }
+
+    // 校验：重叠区域内逐行比较哈希
+    const int displacement = bestIndex - effHeight;
+    const int overlapRows = effHeight - qAbs(displacement);
+    if (overlapRows < MIN_OVERLAP_HEIGHT) {
+        return estimate;
+    }
+    const int newStart = qMax(0, -displacement);
+    int matchedRows = 0;
+    for (int y = newStart; y < newStart + overlapRows; ++y) {
+        if (newHashes[top + y] == lastHashes[top + y + displacement]) {
+            ++matchedRows;
         }
     }
-    
-    return double(similarPixels) / (totalPixels / 4); // 采样了1/4的像素
-}
 
-// 可选：新增开关与阈值设置
-void ScreenshotCapture::enableAdvancedStitching(bool enabled)
-{
-    m_useAdvancedStitching = enabled;
+    estimate.displacement = displacement;
+    estimate.confidence = double(matchedRows) / overlapRows;
+    estimate.effectiveTop = top;
+    estimate.effectiveHeight = effHeight;
+    estimate.isValid = estimate.confidence >= ROW_SIGNATURE_MIN_CONFIDENCE;
+    if (estimate.isValid && displacement != 0) {
+        qDebug() << "行签名 ↕ 对齐: 位移=" << displacement << " 票数=" << bestVotes << "/" << secondVotes
+                 << " 一致行比例=" << estimate.confidence;
+    }
+    return estimate;
 }
 
-void ScreenshotCapture::setTemplateMatchThreshold(double threshold)
+// 相位相关：对两帧有效区域的加窗灰度图做一次 FFT 互功率谱，峰值位置即两个方向的亚像素位移。
+// 与模板匹配不同，搜索范围覆盖整个有效高度的一半，不需要模板条带。
+// 峰值取整后再计算重叠区域的归一化相关系数作为置信度，与其他估计方式使用同一套阈值。
+DisplacementEstimate ScreenshotCapture::estimateDisplacementByPhase(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame)
 {
-    m_templateMatchThreshold = threshold;
+    DisplacementEstimate estimate;
+    int top = 0;
+    int effHeight = 0;
+    if (!effectiveRowRange(newFrame.height(), top, effHeight)) {
+        return estimate;
+    }
+
+    cv::Mat lastGray, newGray;
+    lastFrame.gray().rowRange(top, top + effHeight).convertTo(lastGray, CV_32F);
+    newFrame.gray().rowRange(top, top + effHeight).convertTo(newGray, CV_32F);
+    if (m_phaseWindow.size() != lastGray.size()) {
+        cv::createHanningWindow(m_phaseWindow, lastGray.size(), CV_32F);
+    }
+
+    double response = 0.0;
+    const cv::Point2d shift = cv::phaseCorrelate(lastGray, newGray, m_phaseWindow, &response);
+    if (response < PHASE_MIN_RESPONSE || std::abs(shift.x) > PHASE_MAX_HORIZONTAL_SHIFT) {
+        return estimate;
+    }
+
+    // shift.y > 0 表示新帧内容下移（向上滚动），与 displacement 的符号约定相反
+    const int displacement = -static_cast<int>(std::lround(shift.y));
+    const int overlapRows = effHeight - qAbs(displacement);
+    if (overlapRows < MIN_OVERLAP_HEIGHT) {
+        return estimate;
+    }
+
+    // 校验：新帧第 y 行对应上一帧第 y + displacement 行，比较整个重叠区域
+    const int newStart = qMax(0, -displacement);
+    const cv::Mat lastOverlap = lastFrame.gray().rowRange(top + newStart + displacement, top + newStart + displacement + overlapRows);
+    const cv::Mat newOverlap = newFrame.gray().rowRange(top + newStart, top + newStart + overlapRows);
+    cv::Mat ncc;
+    cv::matchTemplate(lastOverlap, newOverlap, ncc, cv::TM_CCOEFF_NORMED);
+
+    estimate.displacement = displacement;
+    estimate.confidence = ncc.at<float>(0, 0);
+    estimate.effectiveTop = top;
+    estimate.effectiveHeight = effHeight;
+    estimate.isValid = estimate.confidence >= m_templateMatchThreshold;
+    if (estimate.isValid && displacement != 0) {
+        qDebug() << "相位相关 ↕ 位移=" << displacement << "(亚像素" << -shift.y << ", 水平" << shift.x << ")"
+                 << " 峰值能量=" << response << " 重叠相关=" << estimate.confidence;
+    }
+    return estimate;
 }
 
-void ScreenshotCapture::setFixedRegions(const FixedRegion& regions)
+// 在 search 的 [bandTop, bandBottom) 行范围内匹配模板（TM_CCOEFF_NORMED），返回最佳位置（search 的行坐标）
+bool ScreenshotCapture::matchTemplateInBand(const cv::Mat& search, const cv::Mat& tmpl, int bandTop, int bandBottom,
+                                            int& matchY, double& score)
 {
-    m_fixedRegions = regions;
+    bandTop = qMax(0, bandTop);
+    bandBottom = qMin(search.rows, bandBottom);
+    if (tmpl.empty() || bandBottom - bandTop < tmpl.rows || search.cols < tmpl.cols) {
+        return false;
+    }
+
+    cv::Mat matchRes;
+    cv::matchTemplate(search.rowRange(bandTop, bandBottom), tmpl, matchRes, cv::TM_CCOEFF_NORMED);
+
+    double minVal = 0.0;
+    cv::Point minLoc, maxLoc;
+    cv::minMaxLoc(matchRes, &minVal, &score, &minLoc, &maxLoc);
+    matchY = bandTop + maxLoc.y;
+    return true;
 }
 
-// 将 QImage 转换为 OpenCV BGR Mat
-cv::Mat ScreenshotCapture::qImageToCvBgr(const QImage& qImage) const
+// 选择用于粗匹配的金字塔层：模板缩小后仍保留足够的行数时，层级越高越省
+int ScreenshotCapture::pyramidLevelForTemplate(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame, int templateHeight) const
 {
-    if (qImage.isNull()) return cv::Mat();
-    QImage img = qImage.convertToFormat(QImage::Format_ARGB32);
-    cv::Mat bgra(img.height(), img.width(), CV_8UC4, const_cast<uchar*>(img.bits()), img.bytesPerLine());
-    cv::Mat bgr;
-    cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
-    return bgr;
+    const int levels = int(qMin(lastFrame.pyramid().size(), newFrame.pyramid().size()));
+    int level = 0;
+    while (level + 1 < levels && (templateHeight >> (level + 1)) >= PYRAMID_MIN_TEMPLATE_ROWS) {
+        ++level;
+    }
+    return level;
 }
 
-// 用 OpenCV 模板匹配实现重叠区域检测（CV_TM_CCOEFF_NORMED）
-OverlapResult ScreenshotCapture::findOverlapRegion(const QImage& img1, const QImage& img2, ScrollDirection direction)
+// 统一的带符号位移估计：在新帧有效区域中部选一条纹理最丰富的模板，
+// 在上一帧有效区域内只做一次模板匹配，匹配位置与模板位置之差即为位移（两个方向一起覆盖）
+DisplacementEstimate ScreenshotCapture::estimateDisplacementByTemplate(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame)
 {
-    OverlapResult result;
+    DisplacementEstimate estimate;
     if (!m_useAdvancedStitching) {
-        // 回退到原有实现（如果需要，可在此保留旧逻辑）
-        return result;
+        return estimate;
     }
 
-    if (img1.isNull() || img2.isNull() || img1.size() != img2.size()) {
-        return result;
-    }
-
-    const int origWidth = img1.width();
-    const int origHeight = img1.height();
-
     // 按固定区域裁剪有效区域，提高匹配鲁棒性
-    int topCrop = (m_fixedRegions.hasTopRegion ? m_fixedRegions.topRegion.height() : 0);
-    int bottomCrop = (m_fixedRegions.hasBottomRegion ? m_fixedRegions.bottomRegion.height() : 0);
-    int effHeight = origHeight - topCrop - bottomCrop;
-    if (effHeight < MIN_OVERLAP_HEIGHT + 5) {
-        // 有效高度过小，放弃匹配
-        return result;
+    int topCrop = 0;
+    int effHeight = 0;
+    if (!effectiveRowRange(newFrame.height(), topCrop, effHeight)) {
+        return estimate;
+    }
+    const int bottomCrop = newFrame.height() - topCrop - effHeight;
+    // 模板高度按设备像素比放大，HiDPI 下覆盖相同的逻辑内容，也能使用更低的金字塔层
+    const qreal dpr = qMax<qreal>(1.0, newFrame.image().devicePixelRatio());
+    const int tmplH = std::min(qRound(TEMPLATE_HEIGHT * dpr), effHeight);
+    if (tmplH < MIN_OVERLAP_HEIGHT) {
+        return estimate;
+    }
+
+    // 模板位置：在有效区域中间一半的范围内取行方差之和最大的窗口，避开空白行；
+    // 模板越靠中间，向上/向下可搜索的距离越均衡
+    const QVector<double>& variance = newFrame.rowVariance();
+    const int centerTop = (effHeight - tmplH) / 2;
+    const int lowTop = qMax(0, centerTop - effHeight / 4);
+    const int highTop = qMin(effHeight - tmplH, centerTop + effHeight / 4);
+    double windowSum = 0.0;
+    for (int y = 0; y < tmplH; ++y) {
+        windowSum += variance[topCrop + lowTop + y];
+    }
+    int tmplTop = lowTop;
+    double bestSum = windowSum;
+    for (int top = lowTop + 1; top <= highTop; ++top) {
+        windowSum += variance[topCrop + top + tmplH - 1] - variance[topCrop + top - 1];
+        if (windowSum > bestSum || (windowSum == bestSum && qAbs(top - centerTop) < qAbs(tmplTop - centerTop))) {
+            bestSum = windowSum;
+            tmplTop = top;
+        }
     }
 
-    QImage img1Eff = img1.copy(0, topCrop, origWidth, effHeight);
-    QImage img2Eff = img2.copy(0, topCrop, origWidth, effHeight);
-
-    cv::Mat src1Bgr = qImageToCvBgr(img1Eff);
-    cv::Mat src2Bgr = qImageToCvBgr(img2Eff);
-    if (src1Bgr.empty() || src2Bgr.empty()) {
-        return result;
+    const cv::Mat searchGray = lastFrame.gray().rowRange(topCrop, topCrop + effHeight);
+    const cv::Mat tmpl = newFrame.gray().rowRange(topCrop + tmplTop, topCrop + tmplTop + tmplH);
+
+    int matchY = -1;
+    double maxVal = 0.0;
+
+    // 运动预测：先在预测位移附近的窄窗口内搜索，未命中再扩大到整个有效区域
+    if (m_motionModel.hasPrediction()) {
+        int predicted = 0;
+        int radius = 0;
+        m_motionModel.predict(newFrame.timestampMs() - lastFrame.timestampMs(), predicted, radius);
+        const int bandTop = qMax(0, tmplTop + predicted - radius);
+        const int bandBottom = qMin(effHeight, tmplTop + predicted + tmplH + radius);
+        // 峰值贴在窗口边缘（且边缘不是图像边界）时，真实位置可能在窗口之外，按未命中处理
+        if (matchTemplateInBand(searchGray, tmpl, bandTop, bandBottom, matchY, maxVal)
+            && maxVal >= m_templateMatchThreshold
+            && (matchY > bandTop || bandTop == 0)
+            && (matchY + tmplH < bandBottom || bandBottom == effHeight)) {
+            m_motionHitCount++;
+        } else {
+            matchY = -1;
+            m_motionModel.markMiss();
+            m_motionMissCount++;
+        }
     }
 
-    cv::Mat src1Gray, src2Gray;
-    cv::cvtColor(src1Bgr, src1Gray, cv::COLOR_BGR2GRAY);
-    cv::cvtColor(src2Bgr, src2Gray, cv::COLOR_BGR2GRAY);
-
-    int tmplH = std::min(TEMPLATE_HEIGHT, src2Gray.rows);
-    if (tmplH < MIN_OVERLAP_HEIGHT) {
-        return result;
+    // 由粗到细：先在金字塔低分辨率层上定位，再只在全分辨率的几行范围内精确匹配；
+    // 精匹配达不到阈值（例如细小文字在缩小后失真）时才做全分辨率全范围搜索
+    const int level = (matchY < 0) ? pyramidLevelForTemplate(lastFrame, newFrame, tmplH) : 0;
+    if (level > 0) {
+        const int scale = 1 << level;
+        const cv::Mat& coarseLast = lastFrame.pyramid()[level];
+        const cv::Mat& coarseNew = newFrame.pyramid()[level];
+        const int searchTop = (topCrop + scale - 1) / scale;
+        const int searchBottom = qMin((topCrop + effHeight) / scale, coarseLast.rows);
+        const int coarseTmplTop = (topCrop + tmplTop + scale - 1) / scale;
+        const int coarseTmplBottom = qMin((topCrop + tmplTop + tmplH) / scale, coarseNew.rows);
+        int coarseY = -1;
+        double coarseVal = 0.0;
+        if (coarseTmplBottom > coarseTmplTop
+            && matchTemplateInBand(coarseLast.rowRange(searchTop, searchBottom),
+                                   coarseNew.rowRange(coarseTmplTop, coarseTmplBottom),
+                                   0, searchBottom - searchTop, coarseY, coarseVal)) {
+            // 低分辨率位移换算回全分辨率，再在其附近几行内精确匹配
+            const int coarseDisplacement = ((searchTop + coarseY) - coarseTmplTop) * scale;
+            const int margin = scale * 2 + 2;
+            const int bandTop = qMax(0, tmplTop + coarseDisplacement - margin);
+            const int bandBottom = qMin(effHeight, tmplTop + coarseDisplacement + tmplH + margin);
+            if (matchTemplateInBand(searchGray, tmpl, bandTop, bandBottom, matchY, maxVal)
+                && maxVal >= m_templateMatchThreshold) {
+                m_pyramidMatchCount++;
+            } else {
+                matchY = -1;
+            }
+        }
+    }
+    if (matchY < 0) {
+        if (level > 0) {
+            m_pyramidFallbackCount++;
+        }
+        if (!matchTemplateInBand(searchGray, tmpl, 0, effHeight, matchY, maxVal)) {
+            return estimate;
+        }
     }
 
-    cv::Mat tmpl;
-    if (direction == ScrollDirection::Down) {
-        // B 的顶部作为模板（文档策略）
-        tmpl = src2Gray.rowRange(0, tmplH);
-    } else { // ScrollDirection::Up
-        // B 的底部作为模板
-        tmpl = src2Gray.rowRange(src2Gray.rows - tmplH, src2Gray.rows);
+    estimate.displacement = matchY - tmplTop;
+    estimate.confidence = maxVal;
+    estimate.effectiveTop = topCrop;
+    estimate.effectiveHeight = effHeight;
+    // 使用可调阈值，默认 0.8
+    estimate.isValid = maxVal >= m_templateMatchThreshold;
+    if (estimate.isValid && estimate.displacement != 0) {
+        qDebug() << "OpenCV ↕ 匹配: 模板y=" << tmplTop << " 匹配y=" << matchY << " 位移=" << estimate.displacement
+                 << " 相似度=" << maxVal << "(裁剪 top=" << topCrop << ", bottom=" << bottomCrop << ")";
     }
+    return estimate;
+}
 
-    cv::Mat matchRes;
-    cv::matchTemplate(src1Gray, tmpl, matchRes, cv::TM_CCOEFF_NORMED);
+// 可选：新增开关与阈值设置
+void ScreenshotCapture::enableAdvancedStitching(bool enabled)
+{
+    m_useAdvancedStitching = enabled;
+}
 
-    double minVal = 0.0, maxVal = 0.0;
-    cv::Point minLoc, maxLoc;
-    cv::minMaxLoc(matchRes, &minVal, &maxVal, &minLoc, &maxLoc);
+void ScreenshotCapture::setTemplateMatchThreshold(double threshold)
+{
+    m_templateMatchThreshold = threshold;
+}
 
-    // 使用可调阈值，默认 0.8
-    const double threshold = m_templateMatchThreshold;
-    if (maxVal < threshold) {
-        // 未达到阈值
-        return result;
-    }
+void ScreenshotCapture::setFixedRegions(const FixedRegion& regions)
+{
+    m_fixedRegions = regions;
+}
 
-    // 计算重叠高度（基于匹配 y）
-    int overlapHeight = 0;
-    if (direction == ScrollDirection::Down) {
-        // 模板是 B 顶部在 A 中的匹配起点，重叠 = 有效高 - y
-        overlapHeight = effHeight - maxLoc.y;
-        overlapHeight = std::min(overlapHeight, OVERLAP_SEARCH_HEIGHT);
-        if (overlapHeight >= MIN_OVERLAP_HEIGHT && overlapHeight <= effHeight) {
-            result.similarity = maxVal;
-            // 映射回原图坐标：原图底部减去重叠并扣除底部裁剪
-            int yOrig = (origHeight - overlapHeight - bottomCrop);
-            result.rect = QRect(0, yOrig, origWidth, overlapHeight);
-            qDebug() << "OpenCV ↓ 匹配: y=" << maxLoc.y << " 相似度=" << maxVal << " 重叠=" << overlapHeight
-                     << "(裁剪 top=" << topCrop << ", bottom=" << bottomCrop << ")";
-        }
-    } else { // Up
-        // 模板是 B 底部在 A 中的匹配范围，重叠 = y + 模板高度
-        overlapHeight = maxLoc.y + tmpl.rows;
-        overlapHeight = std::min(overlapHeight, OVERLAP_SEARCH_HEIGHT);
-        if (overlapHeight >= MIN_OVERLAP_HEIGHT && overlapHeight <= effHeight) {
-            result.similarity = maxVal;
-            // 映射回原图坐标：原图顶部加上裁剪偏移
-            int yOrig = topCrop;
-            result.rect = QRect(0, yOrig, origWidth, overlapHeight);
-            qDebug() << "OpenCV ↑ 匹配: y=" << maxLoc.y << " 相似度=" << maxVal << " 重叠=" << overlapHeight
-                     << "(裁剪 top=" << topCrop << ", bottom=" << bottomCrop << ")";
-        }
+// 将 32 位 QImage 包装为 OpenCV BGRA Mat（零拷贝，Mat 直接引用 QImage 的像素内存）
+// 注意：返回的 Mat 不持有数据，使用期间调用方必须保证 qImage 存活
+cv::Mat ScreenshotCapture::qImageToCvMat(const QImage& qImage) const
+{
+    if (qImage.isNull()) return cv::Mat();
+    switch (qImage.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return cv::Mat(qImage.height(), qImage.width(), CV_8UC4,
+                       const_cast<uchar*>(qImage.constBits()), qImage.bytesPerLine());
+    default:
+        return cv::Mat();
     }
+}
 
-    // 如果结果仍不满足最小重叠要求，则清空
-    if (result.rect.isEmpty() || result.rect.height() < MIN_OVERLAP_HEIGHT) {
-        result = OverlapResult{};
+// 将 QImage 转换为 OpenCV BGR Mat
+cv::Mat ScreenshotCapture::qImageToCvBgr(const QImage& qImage) const
+{
+    if (qImage.isNull()) return cv::Mat();
+    // 32 位格式直接包装，避免 convertToFormat 产生整帧拷贝
+    QImage img = qImage;
+    cv::Mat bgra = qImageToCvMat(img);
+    if (bgra.empty()) {
+        img = qImage.convertToFormat(QImage::Format_ARGB32);
+        bgra = cv::Mat(img.height(), img.width(), CV_8UC4, const_cast<uchar*>(img.constBits()), img.bytesPerLine());
     }
-    return result;
+    cv::Mat bgr;
+    cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
+    return bgr;
 }
 
 QImage ScreenshotCapture::extractNewContent(const QImage& newImage, const ScrollInfo& scrollInfo) {
@@ -616,77 +1539,13 @@ QImage ScreenshotCapture::extractNewContent(const QImage& newImage, const Scroll
     return newContent;
 }
 
-bool ScreenshotCapture::isContentDuplicate(const QPixmap& newContent, const ScrollInfo& scrollInfo)
-{
-    if (newContent.isNull() || m_globalRegions.isEmpty()) {
-        return false;
-    }
-    QImage newImg = newContent.toImage();
-    for (const GlobalContentRegion& region : m_globalRegions) {
-        QImage existingImg = region.image.toImage();
-        // 完全重复判定（较低阈值）
-        if (newImg.size() == existingImg.size()) {
-            double similarity = calculateImageSimilarity(newImg, existingImg, QRect(0, 0, newImg.width(), newImg.height()));
-            qDebug() << "[去重] 完全重复判定，相似度：" << similarity;
-            if (similarity > 0.95) {
-                qDebug() << "检测到完全重复内容，相似度：" << similarity << "新内容尺寸：" << newImg.size() << "已存在区域：" << region.logicalRect;
-                return true;
-            }
-        }
-        // 检查部分重叠（较低阈值+重叠高度限制）
-        if (newImg.height() <= region.image.height() && newImg.width() == region.image.width()) {
-            for (int yOffset = 0; yOffset <= region.image.height() - newImg.height(); yOffset += 5) {
-                QRect checkRect(0, yOffset, newImg.width(), newImg.height());
-                QRect newRect(0, 0, newImg.width(), newImg.height());
-                double similarity = calculateImageSimilarity(newImg, existingImg, newRect, checkRect);
-                qDebug() << "[去重] 部分重叠判定，相似度：" << similarity << "Y偏移：" << yOffset;
-                if (similarity > 0.90 && newImg.height() > 15) {
-                    qDebug() << "检测到部分重复内容，相似度：" << similarity << "Y偏移：" << yOffset << "新内容尺寸：" << newImg.size();
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-
-bool ScreenshotCapture::isContentInGlobalRegion(const QPixmap& newContent, const QRect& logicalRect)
-{
-    if (newContent.isNull() || m_globalRegions.isEmpty()) {
-        return false;
-    }
-    QImage newImg = newContent.toImage();
-    for (const GlobalContentRegion& region : m_globalRegions) {
-        QRect intersection = logicalRect.intersected(region.logicalRect);
-        if (intersection.isEmpty()) {
-            continue;
-        }
-        int overlapHeight = intersection.height();
-        if (overlapHeight < 15) { // 降低重叠高度阈值
-            continue;
-        }
-        QRect newContentOverlap = QRect(0, intersection.y() - logicalRect.y(), intersection.width(), overlapHeight);
-        QRect existingOverlap = QRect(0, intersection.y() - region.logicalRect.y(), intersection.width(), overlapHeight);
-        if (newContentOverlap.y() < 0 || newContentOverlap.bottom() > newImg.height() || existingOverlap.y() < 0 || existingOverlap.bottom() > region.image.height()) {
-            continue;
-        }
-        QImage existingImg = region.image.toImage();
-        double similarity = calculateImageSimilarity(newImg, existingImg, newContentOverlap, existingOverlap);
-        qDebug() << "[全局重叠] 判定相似度：" << similarity;
-        if (similarity > 0.92) { // 降低阈值
-            return true;
-        }
-    }
-    return false;
-}
-
-void ScreenshotCapture::updateGlobalRegion(const QPixmap& image, const QRect& logicalRect)
+void ScreenshotCapture::updateGlobalRegion(const QImage& image, const QRect& logicalRect)
 {
     GlobalContentRegion newRegion;
     newRegion.image = image;
     newRegion.logicalRect = logicalRect;
-    newRegion.order = m_globalRegions.size() + 1;
-    m_globalRegions.append(newRegion);
+    newRegion.order = ++m_regionOrder;
+    appendGlobalRegion(newRegion);
     
     // 扩展全局边界
     if (m_globalBounds.isEmpty()) {
@@ -697,16 +1556,38 @@ void ScreenshotCapture::updateGlobalRegion(const QPixmap& image, const QRect& lo
 }
 
 void ScreenshotCapture::addNewContent(const QImage& newContent, const ScrollInfo& scrollInfo)
+{
+    GlobalContentRegion newSegment;
+    if (placeNewContent(newContent, scrollInfo, ContentSignature(), newSegment)) {
+        appendGlobalRegion(newSegment);
+    }
+}
+
+// GUI 线程加入全局区域，并增量绘制到长图画布（流水线中由合成线程绘制，见 runComposeStage）
+void ScreenshotCapture::appendGlobalRegion(const GlobalContentRegion& region)
+{
+    m_canvas->blit(region.image, region.logicalRect.topLeft());
+    m_globalRegions.append(region);
+    m_globalRegions.last().image = QImage();  // 像素已在画布中，全局区域只保留位置信息
+}
+
+bool ScreenshotCapture::placeNewContent(const QImage& newContent, const ScrollInfo& scrollInfo, const ContentSignature& signature,
+                                        GlobalContentRegion& newSegment, const QRect& registeredRect)
 {
     if (newContent.isNull() || newContent.height() < 15) { // 新内容无效或太小
         qDebug() << "新内容无效或高度过小，跳过拼接:" << newContent.size();
-        return;
+        return false;
     }
     if (!newContent.isNull()) {
         // 现在newContent已经是纯净的新内容，不包含重叠部分
         QRect logicalRect;
         
-        if (scrollInfo.direction == ScrollDirection::Down) {
+        if (!registeredRect.isEmpty()) {
+            // 配准模式：直接使用检测阶段算出的绝对位置
+            logicalRect = registeredRect;
+            m_currentScrollPos = qMax(m_currentScrollPos, logicalRect.y() + logicalRect.height());
+            
+        } else if (scrollInfo.direction == ScrollDirection::Down) {
             // 向下滚动：新内容添加到当前内容的底部，确保连续无重叠
             logicalRect = QRect(0, m_currentScrollPos, newContent.width(), newContent.height());
             m_currentScrollPos += newContent.height();  // 更新当前位置到新内容的底部
@@ -729,18 +1610,18 @@ void ScreenshotCapture::addNewContent(const QImage& newContent, const ScrollInfo
             }
         }
         
-        // 添加到覆盖区域管理
-        addToCoveredRegions(QPixmap::fromImage(newContent), logicalRect, scrollInfo.direction, 0);
+        // 添加到覆盖区域管理（配准模式按位置判断重复，不需要记录内容）
+        if (registeredRect.isEmpty()) {
+            addToCoveredRegions(newContent, logicalRect, scrollInfo.direction, 0, signature);
+        }
 
-        // 创建新的内容段并添加到全局区域
-        GlobalContentRegion newSegment;
+        // 创建新的内容段（由调用方按顺序加入全局区域）
         newSegment.logicalRect = logicalRect;
-        newSegment.image = QPixmap::fromImage(newContent);
+        newSegment.image = newContent;
         newSegment.overlapHeight = 0;  // 新内容没有重叠
         newSegment.scrollDirection = scrollInfo.direction;
-        newSegment.order = m_globalRegions.size() + 1;
+        newSegment.order = ++m_regionOrder;
 
-        m_globalRegions.append(newSegment);
         updateGlobalBounds(logicalRect);
 
         qDebug() << "✅ 添加新内容片段" << newSegment.order << ": \"" << 
@@ -752,89 +1633,15 @@ void ScreenshotCapture::addNewContent(const QImage& newContent, const ScrollInfo
 
         updateCaptureStatus();
     }
+    return true;
 }
 
-QPixmap ScreenshotCapture::combineImages() const
+QPixmap ScreenshotCapture::createPreviewImage()
 {
-    if (m_globalRegions.isEmpty()) {
+    if (m_canvas->isEmpty()) {
         return m_baseImage;
     }
-    
-    // 使用全局区域创建真正的连贯长图
-    return createGlobalCombinedImage();
-}
-
-QPixmap ScreenshotCapture::createGlobalCombinedImage() const
-{
-    if (m_globalRegions.isEmpty()) {
-        return QPixmap();
-    }
-
-    // 计算所有全局区域的逻辑边界
-    QRect finalLogicalBounds;
-    for (const GlobalContentRegion& region : m_globalRegions) {
-        if (finalLogicalBounds.isEmpty()) {
-            finalLogicalBounds = region.logicalRect;
-        } else {
-            finalLogicalBounds = finalLogicalBounds.united(region.logicalRect);
-        }
-    }
-
-    // 创建最终图片，使用透明背景
-    QPixmap finalImage(finalLogicalBounds.width(), finalLogicalBounds.height());
-    finalImage.fill(Qt::transparent);
-
-    QPainter painter(&finalImage);
-    painter.setRenderHint(QPainter::Antialiasing, false);  // 关闭抗锯齿以保持像素精确
-    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
-    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-
-    // 按Y坐标排序绘制区域，确保正确的层次
-    QList<GlobalContentRegion> sortedRegions = m_globalRegions;
-    std::sort(sortedRegions.begin(), sortedRegions.end(), 
-              [](const GlobalContentRegion& a, const GlobalContentRegion& b) {
-                  return a.logicalRect.y() < b.logicalRect.y();
-              });
-
-    // 打印拼接结构信息
-    qDebug() << "🔧 拼接结构分析 - 总片段数:" << sortedRegions.size() << "最终尺寸:" << finalImage.size();
-    for (int i = 0; i < sortedRegions.size(); ++i) {
-        const GlobalContentRegion& region = sortedRegions[i];
-        int relativeY = region.logicalRect.y() - finalLogicalBounds.y();
-        qDebug() << QString("   片段%1: Y位置=%2 尺寸=%3x%4 相对位置=%5")
-                    .arg(i + 1)
-                    .arg(region.logicalRect.y())
-                    .arg(region.image.width())
-                    .arg(region.image.height())
-                    .arg(relativeY);
-    }
-
-    for (const GlobalContentRegion& region : sortedRegions) {
-        // 计算在最终图片中的相对位置
-        int relativeX = region.logicalRect.x() - finalLogicalBounds.x();
-        int relativeY = region.logicalRect.y() - finalLogicalBounds.y();
-        
-        // 确保绘制位置在有效范围内
-        if (relativeX >= 0 && relativeY >= 0 && 
-            relativeX < finalImage.width() && relativeY < finalImage.height()) {
-            
-            // 计算实际需要绘制的区域
-            QRect drawRect(relativeX, relativeY, region.image.width(), region.image.height());
-            QRect finalRect(0, 0, finalImage.width(), finalImage.height());
-            QRect clippedRect = drawRect.intersected(finalRect);
-            
-            if (!clippedRect.isEmpty()) {
-                // 计算源图像的对应区域
-                QRect sourceRect(clippedRect.x() - relativeX, clippedRect.y() - relativeY,
-                               clippedRect.width(), clippedRect.height());
-                
-                painter.drawPixmap(clippedRect, region.image, sourceRect);
-            }
-        }
-    }
-
-    qDebug() << "✅ 拼接完成 - 最终长图尺寸:" << finalImage.size() << "Y范围:" << finalLogicalBounds.y() << "到" << finalLogicalBounds.bottom();
-    return finalImage;
+    return QPixmap::fromImage(m_canvas->preview());
 }
 
 void ScreenshotCapture::updateCaptureStatus()
@@ -842,7 +1649,7 @@ void ScreenshotCapture::updateCaptureStatus()
     emit captureStatusChanged(QString("滚动中... 已捕获 %1 个片段").arg(m_newContents.size() + 1));
 }
 
-bool ScreenshotCapture::isContentAlreadyCovered(const QPixmap& newContent, const QRect& logicalRect)
+bool ScreenshotCapture::isContentAlreadyCovered(const QImage& newContent, const QRect& logicalRect, const ContentSignature& signature)
 {
     if (newContent.isNull() || m_coveredRegions.isEmpty()) {
         // 重置连续重复计数
@@ -863,28 +1670,64 @@ bool ScreenshotCapture::isContentAlreadyCovered(const QPixmap& newContent, const
         }
     }
     
-    // 创建新内容的指纹
-    QString newFingerprint = createContentFingerprint(newContent);
+    // 新内容的感知哈希：优先使用检测阶段从灰度平面算好的值
+    const quint64 newHash = signature.hasPerceptualHash ? signature.perceptualHash : PerceptualHash::dHash(newContent);
     
-    // 检查新内容区域是否与已覆盖区域重叠
-    for (const CoveredRegion& covered : m_coveredRegions) {
-        // 快速指纹比较
-        if (newFingerprint == covered.contentFingerprint) {
-            qDebug() << "指纹匹配：发现完全相同的内容";
+    // 新内容的比较缩略图：第一次需要像素比较时生成，本次检测中与所有区域的比较共用
+    SimilarityThumbnail newThumbnail;
+    auto similarityTo = [&](const CoveredRegion& covered) {
+        if (newThumbnail.image.isNull()) {
+            newThumbnail = createSimilarityThumbnail(newContent);
+        }
+        return calculateContentSimilarity(newThumbnail, covered.thumbnail);
+    };
+    
+    // 感知哈希索引：取哈希几乎相同的已覆盖内容，再用指纹或像素比较确认。
+    // 只有逻辑 Y 范围与新内容相交的候选才接受像素比较；不相交的候选（页面中别处的相似内容，
+    // 如表格行、列表项）必须指纹完全一致，否则把合法的新内容误判为重复
+    const int newTop = logicalRect.top();
+    const int newBottom = logicalRect.top() + logicalRect.height();
+    const QList<int> candidates = m_coveredHashIndex.query(newHash, PHASH_MATCH_DISTANCE);
+    for (int regionId : candidates) {
+        const CoveredRegion* covered = coveredRegionById(regionId);
+        if (!covered) {
+            continue;
+        }
+        const bool sameFingerprint = !signature.fingerprint.isEmpty() && signature.fingerprint == covered->contentFingerprint;
+        const int coveredTop = covered->logicalRect.top();
+        const bool intersects = coveredTop < newBottom && coveredTop + covered->logicalRect.height() > newTop;
+        if (sameFingerprint || (intersects && similarityTo(*covered) > 0.85)) {
+            qDebug() << "感知哈希匹配：发现相同的内容 距离" << PerceptualHash::distance(newHash, covered->perceptualHash)
+                     << (sameFingerprint ? "(指纹一致)" : "(像素确认)");
+            m_hashIndexHitCount++;
             m_duplicateSkipCount++;
             m_consecutiveDuplicates++;
             m_lastDuplicateTime = currentTime;
             return true;
         }
+    }
+    
+    // 检查新内容区域是否与已覆盖区域重叠：只取逻辑 Y 范围与新内容相交的区域
+    const QList<int> overlapping = m_coveredYIndex.query(newTop, newBottom);
+    for (int regionId : overlapping) {
+        const CoveredRegion* coveredPtr = coveredRegionById(regionId);
+        if (!coveredPtr) {
+            continue;
+        }
+        const CoveredRegion& covered = *coveredPtr;
         
         // 检查区域重叠 - 提高重叠阈值
         if (!isOverlapSignificant(logicalRect, covered.logicalRect, 0.7)) {
             continue;
         }
         
+        // 感知哈希相差太大的内容不可能达到下面的相似度阈值，跳过像素比较
+        if (PerceptualHash::distance(newHash, covered.perceptualHash) > PHASH_SIMILAR_DISTANCE) {
+            continue;
+        }
+        
         // 计算内容相似度
-        QPixmap coveredPixmap = QPixmap::fromImage(covered.contentHash);
-        double similarity = calculateContentSimilarity(newContent, coveredPixmap);
+        double similarity = similarityTo(covered);
         
         // 提高相似度阈值到85%
         if (similarity > 0.85) {
@@ -929,91 +1772,46 @@ bool ScreenshotCapture::isContentAlreadyCovered(const QPixmap& newContent, const
     return false;
 }
 
-QString ScreenshotCapture::createContentFingerprint(const QPixmap& content)
+SimilarityThumbnail ScreenshotCapture::createSimilarityThumbnail(const QImage& content)
 {
+    SimilarityThumbnail thumbnail;
     if (content.isNull()) {
-        return QString();
-    }
-    
-    // 创建更精确的内容指纹
-    QImage img = content.toImage();
-    QCryptographicHash hash(QCryptographicHash::Md5);
-    
-    // 缩放到固定尺寸以提高比较效率，但保持更高精度
-    QImage scaledImg = img.scaled(96, 96, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    
-    // 减少采样步长，提高精度
-    int sampleStep = 1;  // 每个像素都采样
-    
-    // 添加图像尺寸信息到指纹中
-    hash.addData(QByteArray::number(scaledImg.width()));
-    hash.addData(QByteArray::number(scaledImg.height()));
-    
-    // 按采样步长处理像素
-    for (int y = 0; y < scaledImg.height(); y += sampleStep) {
-        for (int x = 0; x < scaledImg.width(); x += sampleStep) {
-            QRgb pixel = scaledImg.pixel(x, y);
-            hash.addData(QByteArrayView(reinterpret_cast<const char*>(&pixel), sizeof(QRgb)));
-        }
+        return thumbnail;
     }
     
-    // 添加额外的统计信息以提高唯一性
-    qint64 totalBrightness = 0;
-    for (int y = 0; y < scaledImg.height(); y++) {
-        for (int x = 0; x < scaledImg.width(); x++) {
-            QRgb pixel = scaledImg.pixel(x, y);
-            totalBrightness += qRed(pixel) + qGreen(pixel) + qBlue(pixel);
-        }
+    thumbnail.sourceSize = content.size();
+    thumbnail.image = content.scaled(128, 128, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    if (thumbnail.image.depth() != 32) {
+        thumbnail.image = thumbnail.image.convertToFormat(QImage::Format_RGB32);
     }
-    hash.addData(QByteArray::number(totalBrightness));
-    
-    return hash.result().toHex();
+    return thumbnail;
 }
 
-double ScreenshotCapture::calculateContentSimilarity(const QPixmap& content1, const QPixmap& content2)
+double ScreenshotCapture::calculateContentSimilarity(const QImage& content1, const QImage& content2)
 {
     if (content1.isNull() || content2.isNull()) {
         return 0.0;
     }
-    
-    // 快速检查：如果尺寸差异太大，直接返回低相似度
-    if (abs(content1.width() - content2.width()) > 30 || 
-        abs(content1.height() - content2.height()) > 30) {
+    return calculateContentSimilarity(createSimilarityThumbnail(content1), createSimilarityThumbnail(content2));
+}
+
+double ScreenshotCapture::calculateContentSimilarity(const SimilarityThumbnail& thumb1, const SimilarityThumbnail& thumb2)
+{
+    if (thumb1.image.isNull() || thumb2.image.isNull()) {
         return 0.0;
     }
     
-    // 使用指纹进行快速比较
-    QString fingerprint1 = createContentFingerprint(content1);
-    QString fingerprint2 = createContentFingerprint(content2);
-    
-    if (fingerprint1 == fingerprint2) {
-        return 1.0;  // 完全相同
+    // 快速检查：如果尺寸差异太大，直接返回低相似度
+    if (abs(thumb1.sourceSize.width() - thumb2.sourceSize.width()) > 30 || 
+        abs(thumb1.sourceSize.height() - thumb2.sourceSize.height()) > 30) {
+        return 0.0;
     }
     
-    // 进行更详细的像素级比较 - 使用更高精度
-    QImage img1 = content1.toImage().scaled(128, 128, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    QImage img2 = content2.toImage().scaled(128, 128, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    
+    // 使用更密集的采样 - 每个像素都检查（公共区域逐行交给 SIMD 内核，直接读缓存的缩略图，不分配内存）
+    const QRect common(0, 0, qMin(thumb1.image.width(), thumb2.image.width()),
+                       qMin(thumb1.image.height(), thumb2.image.height()));
     int totalPixels = 0;
-    int similarPixels = 0;
-    
-    // 使用更密集的采样 - 每个像素都检查
-    for (int y = 0; y < qMin(img1.height(), img2.height()); y++) {
-        for (int x = 0; x < qMin(img1.width(), img2.width()); x++) {
-            QRgb pixel1 = img1.pixel(x, y);
-            QRgb pixel2 = img2.pixel(x, y);
-            
-            int rDiff = abs(qRed(pixel1) - qRed(pixel2));
-            int gDiff = abs(qGreen(pixel1) - qGreen(pixel2));
-            int bDiff = abs(qBlue(pixel1) - qBlue(pixel2));
-            
-            totalPixels++;
-            // 降低容差，提高精度
-            if (rDiff + gDiff + bDiff < 30) {
-                similarPixels++;
-            }
-        }
-    }
+    const int similarPixels = PixelKernels::countSimilarPixels(thumb1.image, common, thumb2.image, common, 30, 1, &totalPixels);
     
     return totalPixels > 0 ? double(similarPixels) / totalPixels : 0.0;
 }
@@ -1036,7 +1834,8 @@ bool ScreenshotCapture::isOverlapSignificant(const QRect& rect1, const QRect& re
     return overlapRatio > threshold;
 }
 
-void ScreenshotCapture::addToCoveredRegions(const QPixmap& newContent, const QRect& logicalRect, ScrollDirection direction, int captureOrder)
+void ScreenshotCapture::addToCoveredRegions(const QImage& newContent, const QRect& logicalRect, ScrollDirection direction, int captureOrder,
+                                            const ContentSignature& signature)
 {
     if (newContent.isNull() || logicalRect.isEmpty()) {
         return;
@@ -1045,13 +1844,19 @@ void ScreenshotCapture::addToCoveredRegions(const QPixmap& newContent, const QRe
     CoveredRegion newCovered;
     newCovered.logicalRect = logicalRect;
     newCovered.contentHash = createContentHash(newContent);
-    newCovered.contentFingerprint = createContentFingerprint(newContent);
+    // 缩略图取自原始新内容：尺寸门限比较的是真实内容尺寸，而不是缩小后的 contentHash
+    newCovered.thumbnail = createSimilarityThumbnail(newContent);
+    newCovered.contentFingerprint = signature.fingerprint;
+    newCovered.perceptualHash = signature.hasPerceptualHash ? signature.perceptualHash : PerceptualHash::dHash(newContent);
+    newCovered.regionId = m_nextCoveredRegionId++;
     newCovered.captureDirection = direction;
     newCovered.captureOrder = captureOrder;
     newCovered.captureTimestamp = QDateTime::currentMSecsSinceEpoch();
     newCovered.actualScreenRect = logicalRect;  // 简化处理
     
     m_coveredRegions.append(newCovered);
+    m_coveredHashIndex.insert(newCovered.perceptualHash, newCovered.regionId);
+    m_coveredYIndex.insert(logicalRect.top(), logicalRect.top() + logicalRect.height(), newCovered.regionId);
     
     // 定期清理旧的覆盖区域
     if (m_coveredRegions.size() > m_maxCoveredRegions) {
@@ -1072,7 +1877,11 @@ void ScreenshotCapture::cleanupOldCoveredRegions()
     if (m_coveredRegions.size() > m_maxCoveredRegions) {
         // 移除最旧的区域
         int removeCount = m_coveredRegions.size() - m_maxCoveredRegions + 20;
+        for (int i = 0; i < removeCount; ++i) {
+            m_coveredYIndex.remove(m_coveredRegions[i].regionId);
+        }
         m_coveredRegions.erase(m_coveredRegions.begin(), m_coveredRegions.begin() + removeCount);
+        rebuildCoveredIndexes();
         
         qDebug() << "清理了" << removeCount << "个旧的覆盖区域，当前数量：" << m_coveredRegions.size();
     }
@@ -1080,21 +1889,66 @@ void ScreenshotCapture::cleanupOldCoveredRegions()
     m_lastCleanupTime = currentTime;
 }
 
+const CoveredRegion* ScreenshotCapture::coveredRegionById(int regionId) const
+{
+    // 区域只在末尾追加、从头部淘汰，regionId 连续递增，可直接换算成下标
+    if (m_coveredRegions.isEmpty()) {
+        return nullptr;
+    }
+    const int index = regionId - m_coveredRegions.first().regionId;
+    if (index < 0 || index >= m_coveredRegions.size()) {
+        return nullptr;
+    }
+    return &m_coveredRegions[index];
+}
+
+void ScreenshotCapture::rebuildCoveredIndexes()
+{
+    // BK 树不支持删除，淘汰旧区域后按剩余区域重建（每淘汰一批才发生一次）；Y 区间索引已逐个删除
+    m_coveredHashIndex.clear();
+    for (const CoveredRegion& covered : m_coveredRegions) {
+        m_coveredHashIndex.insert(covered.perceptualHash, covered.regionId);
+    }
+}
+
 void ScreenshotCapture::logPerformanceMetrics()
 {
     qDebug() << "性能指标：已覆盖区域数" << m_coveredRegions.size() 
-             << "跳过重复次数" << m_duplicateSkipCount
-             << "采样步长" << m_hashSampleStep;
+             << "跳过重复次数" << m_duplicateSkipCount << "(感知哈希命中" << m_hashIndexHitCount << ")"
+             << "采样步长" << m_hashSampleStep
+             << "像素内核" << PixelKernels::implementationName();
+    qDebug() << "滚动位移估计:" << scrollMatcherName()
+             << "行签名命中" << m_rowMatchCount << "次，回退模板匹配" << m_rowMatchFallbackCount << "次"
+             << "| 金字塔粗匹配命中" << m_pyramidMatchCount << "次，全分辨率重搜" << m_pyramidFallbackCount << "次"
+             << "| 预测窗口命中" << m_motionHitCount << "次，未命中" << m_motionMissCount << "次"
+             << "| 画面未变化跳过" << m_unchangedFrameCount << "帧";
+    qDebug() << "长图画布:" << m_canvas->bounds() << "图块" << m_canvas->tileCount()
+             << "已换出" << m_canvas->spilledTileCount()
+             << "常驻" << (m_canvas->allocatedBytes() / (1024 * 1024)) << "MB";
+    if (m_useRegistration) {
+        qDebug() << "位置配准: 追加" << m_registeredAppendCount << "次，已覆盖跳过" << m_registeredCoveredCount << "次"
+                 << "长图范围" << m_canvasTop << "~" << m_canvasBottom
+                 << "| 重新定位成功" << m_reanchorCount << "次，失败" << m_reanchorFailCount << "次";
+    }
+    if (m_captureBackend) {
+        const CaptureStats& stats = m_captureBackend->stats();
+        qDebug() << "截图后端:" << m_captureBackend->name()
+                 << "抓取次数" << stats.grabCount << "失败" << stats.failCount
+                 << "平均耗时" << QString::number(stats.averageGrabMs(), 'f', 2) << "ms"
+                 << "最短" << QString::number(stats.minGrabNs / 1e6, 'f', 2) << "ms"
+                 << "最长" << QString::number(stats.maxGrabNs / 1e6, 'f', 2) << "ms"
+                 << "累计像素数据" << (stats.totalBytes / (1024 * 1024)) << "MB";
+    }
 }
 
-QImage ScreenshotCapture::createContentHash(const QPixmap& content)
+QImage ScreenshotCapture::createContentHash(const QImage& content)
 {
     if (content.isNull()) {
         return QImage();
     }
     
     // 创建一个小的缩略图作为内容哈希
-    QImage img = content.toImage();
+    const QImage& img = content;
     QImage hash = img.scaled(50, 50, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     
     return hash;
@@ -1109,7 +1963,14 @@ void ScreenshotCapture::updateGlobalBounds(const QRect& rect) {
 }
 void ScreenshotCapture::processStitchingQueue()
 {
-    // 占位：后续将把拼接任务移至子线程处理
+    // 消费截图线程产生的帧；队列满时生产者已丢弃最旧的帧，这里只按顺序处理剩余帧
+    if (m_captureWorker) {
+        m_captureWorker->acknowledgeFrames();
+    }
+    CaptureTask task;
+    while (m_isCapturing && m_frameRing.tryPop(task)) {
+        processCapturedFrame(task.screenshot, task.timestamp);
+    }
 }
 bool ScreenshotCapture::eventFilter(QObject* obj, QEvent* event)
 {
@@ -1120,28 +1981,13 @@ bool ScreenshotCapture::eventFilter(QObject* obj, QEvent* event)
         // 去抖：限定最小截取间隔
         if (now - m_lastWheelCaptureMs >= qMax(50, m_detectionInterval/2)) {
             m_lastWheelCaptureMs = now;
-            // 立即进行一次检测循环：抓取并处理
-            QPixmap current = captureRegion(m_captureRect);
-            if (!current.isNull() && !m_lastScreenshot.isNull()) {
-                ScrollInfo scrollInfo = detectScroll(m_lastScreenshot.toImage(), current.toImage());
-                if (scrollInfo.hasScroll) {
-                    emit scrollDetected(scrollInfo.direction, scrollInfo.offset);
-                    QImage newContent = extractNewContent(current.toImage(), scrollInfo);
-                    if (!newContent.isNull() && newContent.height() >= MIN_NEW_CONTENT_HEIGHT) {
-                        QRect logicalRect;
-                        if (scrollInfo.direction == ScrollDirection::Down) {
-                            logicalRect = QRect(0, m_currentScrollPos, newContent.width(), newContent.height());
-                        } else {
-                            int currentMinY = m_globalBounds.isEmpty() ? 0 : m_globalBounds.top();
-                            logicalRect = QRect(0, currentMinY - newContent.height(), newContent.width(), newContent.height());
-                        }
-                        if (!isContentAlreadyCovered(QPixmap::fromImage(newContent), logicalRect)) {
-                            addNewContent(newContent, scrollInfo);
-                            m_lastScreenshot = current;
-                            emit newImageCaptured(getCombinedImage());
-                        }
-                    }
-                }
+            if (m_captureWorker) {
+                // 截图线程立即抓取一帧，结果经队列进入拼接流程
+                m_captureWorker->requestGrab();
+            } else {
+                // 立即进行一次检测循环：抓取并处理
+                const QImage frame = captureRegion(m_captureRect);
+                processCapturedFrame(frame, m_captureBackend->frameTimestampMs());
             }
         }
         // 不拦截事件，继续传递
@@ -1151,16 +1997,15 @@ bool ScreenshotCapture::eventFilter(QObject* obj, QEvent* event)
 }
 
 // 新增：固定区域（顶部/底部）简单检测实现
-FixedRegion ScreenshotCapture::detectFixedRegions(const QImage& image)
+FixedRegion ScreenshotCapture::detectFixedRegions(const FrameAnalysis& frame)
 {
     FixedRegion regions;
-    if (image.isNull()) {
+    if (frame.isNull()) {
         return regions;
     }
 
-    QImage img = image.convertToFormat(QImage::Format_RGB32);
-    const int w = img.width();
-    const int h = img.height();
+    const int w = frame.width();
+    const int h = frame.height();
     if (w <= 0 || h <= 0) {
         return regions;
     }
@@ -1168,29 +2013,13 @@ FixedRegion ScreenshotCapture::detectFixedRegions(const QImage& image)
     const int maxScan = qMin(FIXED_REGION_DETECTION_HEIGHT, h / 3); // 限制扫描高度
     const double varianceThreshold = 30.0; // 行内像素方差阈值（越小说明越“单调/固定”）
 
-    auto rowVariance = [&](int y) -> double {
-        const uchar* line = img.constScanLine(y);
-        // 计算灰度均值与方差
-        double sum = 0.0;
-        double sum2 = 0.0;
-        for (int x = 0; x < w; ++x) {
-            const QRgb px = reinterpret_cast<const QRgb*>(line)[x];
-            const int r = qRed(px);
-            const int g = qGreen(px);
-            const int b = qBlue(px);
-            const double gray = 0.299 * r + 0.587 * g + 0.114 * b;
-            sum += gray;
-            sum2 += gray * gray;
-        }
-        const double mean = sum / w;
-        const double var = qMax(0.0, (sum2 / w) - (mean * mean));
-        return var;
-    };
+    // 行灰度方差已在帧分析中算好
+    const QVector<double>& rowVariance = frame.rowVariance();
 
     // 从顶部向下扫描
     int topHeight = 0;
     for (int y = 0; y < maxScan; ++y) {
-        if (rowVariance(y) <= varianceThreshold) {
+        if (rowVariance[y] <= varianceThreshold) {
             ++topHeight;
         } else {
             break;
@@ -1205,7 +2034,7 @@ FixedRegion ScreenshotCapture::detectFixedRegions(const QImage& image)
     // 从底部向上扫描
     int bottomHeight = 0;
     for (int y = 0; y < maxScan; ++y) {
-        if (rowVariance(h - 1 - y) <= varianceThreshold) {
+        if (rowVariance[h - 1 - y] <= varianceThreshold) {
             ++bottomHeight;
         } else {
             break;
@@ -1217,4 +2046,4 @@ FixedRegion ScreenshotCapture::detectFixedRegions(const QImage& image)
     }
 
     return regions;
-}
\ No newline at end of file
+}
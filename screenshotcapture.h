@@ -10,7 +10,6 @@
 #include <QList>
 #include <QImage>
 #include <QDateTime>
-#include <QCryptographicHash>
 #include <QQueue>
 #include <QMutex>
 #include <QThread>
@@ -22,6 +21,20 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "capturebackend.h"
+#include "capturesession.h"
+#include "framering.h"
+#include "stitchingpipeline.h"
+#include "frameanalysis.h"
+#include "scrollmotionmodel.h"
+#include "capturescheduler.h"
+#include "hammingindex.h"
+#include "intervalindex.h"
+#include "canvasindex.h"
+#include "stitchcanvas.h"
+#include <QElapsedTimer>
+#include <QSharedPointer>
+
 enum class ScrollDirection {
     None,
     Up,
@@ -51,21 +64,54 @@ struct OverlapResult {
     double similarity = 0.0;
 };
 
+// 滚动位移估计方式
+enum class ScrollMatcher {
+    Template,       // OpenCV 模板匹配（二维相关）
+    RowSignature,   // 行签名一维对齐，结果不确定时回退到模板匹配
+    PhaseCorrelation // 加窗灰度帧的相位相关（FFT），不受模板高度和重叠上限限制
+};
+
+// 带符号的垂直位移估计结果（一次搜索同时给出方向、距离和置信度）
+// displacement > 0：内容上移（向下滚动）；< 0：内容下移（向上滚动）
+struct DisplacementEstimate {
+    int displacement = 0;
+    double confidence = 0.0;
+    int effectiveTop = 0;       // 参与匹配的有效区域（扣除固定区域后）
+    int effectiveHeight = 0;
+    bool isValid = false;
+};
+
+// 内容相似度比较用的缩略图：每幅图像只生成一次，之后的比较直接读取，不再缩放或分配内存
+struct SimilarityThumbnail {
+    QSize sourceSize;   // 原图尺寸（用于尺寸差异的快速排除）
+    QImage image;       // 128x128 以内、保持比例的 RGB32 缩略图
+};
+
 // 已覆盖区域结构，用于精确记录已截取的内容
 struct CoveredRegion {
     QRect logicalRect;          // 逻辑坐标系中的区域
     QImage contentHash;         // 内容的哈希表示（缩略图）
-    QString contentFingerprint; // 内容指纹（字符串哈希）
+    SimilarityThumbnail thumbnail;  // 新内容的相似度比较缓存（加入时生成一次，保留原始尺寸）
+    QString contentFingerprint; // 内容指纹（行哈希组合，可能为空）
+    quint64 perceptualHash = 0; // 64 位感知哈希（dHash）
+    int regionId = 0;           // 递增编号，用于从感知哈希索引定位区域
     ScrollDirection captureDirection; // 截取时的滚动方向
     int captureOrder;           // 截取顺序
     qint64 captureTimestamp;    // 截取时间戳
     QRect actualScreenRect;     // 实际屏幕坐标（用于重叠检测）
 };
 
+// 新内容的签名：检测阶段从帧分析中得到，去重阶段直接使用，不再重新扫描像素
+struct ContentSignature {
+    QString fingerprint;            // 行哈希指纹（完全相同的内容指纹相同）
+    quint64 perceptualHash = 0;     // 64 位感知哈希
+    bool hasPerceptualHash = false;
+};
+
 // 全局内容区域结构
 struct GlobalContentRegion {
     QRect logicalRect;
-    QPixmap image;
+    QImage image;       // QImage 可在拼接流水线的工作线程中安全使用
     int overlapHeight = 0;
     ScrollDirection scrollDirection = ScrollDirection::None;
     int order = 0;
@@ -79,13 +125,25 @@ struct TemplateMatchResult {
     int overlapHeight = 0;
 };
 
-// 截图任务队列项
+// 截图任务队列项（由截图线程产生，QImage 可安全跨线程传递）
 struct CaptureTask {
-    QPixmap screenshot;
-    qint64 timestamp;
-    int taskId;
+    QImage screenshot;
+    qint64 timestamp = 0;
+    int taskId = -1;
 };
 
+// 流水线检测阶段的产物：已确认滚动并提取出的新内容，交给去重阶段
+struct DetectedFrame {
+    int taskId = -1;
+    qint64 timestamp = 0;
+    ScrollInfo scrollInfo;
+    QImage newContent;
+    ContentSignature signature;  // 新内容的指纹与感知哈希（来自帧分析，去重阶段直接使用）
+    QRect logicalRect;      // 配准模式下新内容在长图中的绝对位置（为空表示由去重阶段按相似度决定）
+};
+
+class CaptureWorker;
+
 // 固定区域信息
 struct FixedRegion {
     QRect topRegion;    // 顶部固定区域（工具栏等）
@@ -101,9 +159,13 @@ class ScreenshotCapture : public QObject
 public:
     explicit ScreenshotCapture(QObject *parent = nullptr);
     ~ScreenshotCapture();
-    // 兼容旧接口
-    QPixmap getCombinedImage() const;
-    QPixmap getCurrentCombinedImage() const;
+    // 长图预览（按图块缩小拼接，不分配整张长图）与长图的实际尺寸
+    QPixmap getPreviewImage() const;
+    QSize combinedImageSize() const;
+    // 导出用的长图画布（共享引用：开始新的截图时换用新画布，后台导出中的旧画布不受影响）
+    // 与画布为空时使用的基础图片
+    QSharedPointer<StitchCanvas> canvas() const;
+    QImage baseImage() const;
     void setDetectionInterval(int interval);
     // 新增公开接口
     QList<QPixmap> getCapturedImages() const;
@@ -117,6 +179,36 @@ public:
     void stopScrollCapture();
     void fixedRegionsDetected(const FixedRegion& regions);
 
+    // 截图后端选择与耗时统计
+    void setCaptureBackend(const QString& name);
+    void setCaptureBackend(CaptureBackend* backend);  // 接管所有权
+    QString captureBackendName() const;
+    CaptureStats captureStats() const;
+
+    // 会话录制与回放：录制实时截图的每一帧；回放时以录制帧代替屏幕输入，走同一套检测/去重/拼接流程
+    void setRecordingPath(const QString& path);
+    bool startReplay(const QString& path, bool realTime);
+    bool isReplaying() const;
+
+    // 是否在独立线程中抓屏（默认开启；回放始终在当前线程按顺序处理）
+    void setCaptureThreadEnabled(bool enabled);
+    // 是否把检测/去重/合成拆成流水线阶段分别在独立线程执行（需同时开启截图线程）
+    void setPipelineEnabled(bool enabled);
+    // 是否按滚动速度自动调整抓取间隔（默认开启；关闭时使用固定的检测间隔）
+    void setAdaptiveCaptureEnabled(bool enabled);
+
+    // 是否按位置配准拼接（默认开启）：每帧由位移换算出在长图中的绝对 Y，
+    // 只追加长图尚未覆盖的行，重复判断退化为区间比较；关闭时使用基于内容相似度的去重
+    void setRegistrationEnabled(bool enabled);
+
+    // 长图画布常驻内存预算（MB，0 表示不限制）：超出后较早的图块换出到内存映射的临时文件
+    void setCanvasMemoryBudget(int megabytes);
+
+    // 滚动位移估计方式："rows"（默认）、"template" 或 "phase"
+    void setScrollMatcher(ScrollMatcher matcher);
+    void setScrollMatcher(const QString& name);
+    QString scrollMatcherName() const;
+
 private slots:
     void onScrollDetectionTimer();
     void processStitchingQueue(); // 新增：处理拼接队列
@@ -125,49 +217,118 @@ protected:
 
 signals:
     void captureStatusChanged(const QString& status);
-    void newImageCaptured(const QPixmap& image);
-    void captureFinished(const QPixmap& combinedImage);
+    void newImageCaptured(const QPixmap& preview);
+    void captureFinished(const QPixmap& preview);
     void scrollDetected(ScrollDirection direction, int offset);
 
 private:
     void updateGlobalBounds(const QRect& rect);
-    ScrollInfo detectScroll(const QImage& lastImg, const QImage& newImg);
-    double calculateImageSimilarity(const QImage& img1, const QImage& img2, const QRect& rect);
-    double calculateImageSimilarity(const QImage& img1, const QImage& img2, const QRect& rect1, const QRect& rect2);
-    OverlapResult findOverlapRegion(const QImage& img1, const QImage& img2, ScrollDirection direction);
+    ScrollInfo detectScroll(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame);
+    DisplacementEstimate estimateDisplacement(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame);
+    DisplacementEstimate estimateDisplacementByTemplate(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame);
+    DisplacementEstimate estimateDisplacementByRows(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame);
+    DisplacementEstimate estimateDisplacementByPhase(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame);
+    bool effectiveRowRange(int frameHeight, int& top, int& height) const;
+    static bool matchTemplateInBand(const cv::Mat& search, const cv::Mat& tmpl, int bandTop, int bandBottom,
+                                    int& matchY, double& score);
+    int pyramidLevelForTemplate(const FrameAnalysis& lastFrame, const FrameAnalysis& newFrame, int templateHeight) const;
     QImage extractNewContent(const QImage& newImage, const ScrollInfo& scrollInfo);
-    bool isContentDuplicate(const QPixmap& newContent, const ScrollInfo& scrollInfo);
-    bool isContentInGlobalRegion(const QPixmap& newContent, const QRect& logicalRect);
-    bool isContentAlreadyCovered(const QPixmap& newContent, const QRect& logicalRect);
-    void addToCoveredRegions(const QPixmap& newContent, const QRect& logicalRect);
-    void addToCoveredRegions(const QPixmap& newContent, const QRect& logicalRect, ScrollDirection direction);
-    QImage createContentHash(const QPixmap& content);
-    QString createContentFingerprint(const QPixmap& content);
-    double calculateContentSimilarity(const QPixmap& content1, const QPixmap& content2);
+    bool isContentAlreadyCovered(const QImage& newContent, const QRect& logicalRect,
+                                 const ContentSignature& signature = ContentSignature());
+    void addToCoveredRegions(const QImage& newContent, const QRect& logicalRect);
+    void addToCoveredRegions(const QImage& newContent, const QRect& logicalRect, ScrollDirection direction);
+    QImage createContentHash(const QImage& content);
+    static SimilarityThumbnail createSimilarityThumbnail(const QImage& content);
+    double calculateContentSimilarity(const QImage& content1, const QImage& content2);
+    static double calculateContentSimilarity(const SimilarityThumbnail& thumb1, const SimilarityThumbnail& thumb2);
     bool isOverlapSignificant(const QRect& rect1, const QRect& rect2, double threshold = 0.6);
     void cleanupOldCoveredRegions();
     void logPerformanceMetrics();
     QPixmap extractNewContentOnly(const QPixmap& newImage, const ScrollInfo& scrollInfo);
-    void updateGlobalRegion(const QPixmap& newContent, const QRect& logicalRect);
-    QPixmap createGlobalCombinedImage() const;
+    void updateGlobalRegion(const QImage& newContent, const QRect& logicalRect);
+    QPixmap createPreviewImage();
     void addNewContent(const QImage& newContent, const ScrollInfo& scrollInfo);
-    void addToCoveredRegions(const QPixmap& newContent, const QRect& logicalRect, ScrollDirection direction, int captureOrder);
-    QPixmap combineImages() const;
+    void appendGlobalRegion(const GlobalContentRegion& region);
+    bool placeNewContent(const QImage& newContent, const ScrollInfo& scrollInfo, const ContentSignature& signature,
+                         GlobalContentRegion& segment, const QRect& registeredRect = QRect());
+    void addToCoveredRegions(const QImage& newContent, const QRect& logicalRect, ScrollDirection direction, int captureOrder,
+                             const ContentSignature& signature = ContentSignature());
+    const CoveredRegion* coveredRegionById(int regionId) const;
+    void rebuildCoveredIndexes();
     void updateCaptureStatus();
     // 新增私有接口
-    QPixmap captureRegion(const QRect& rect);
+    QImage captureRegion(const QRect& rect);
+    QImage grabBoundFrame();
+    bool prepareCaptureBackend();
+    int nextDetectionDelay() const;
+    void finishReplay();
+    void processCapturedFrame(const QImage& currentScreenshot, qint64 timestampMs);
+    bool detectNewContent(const FrameAnalysis& currentFrame, DetectedFrame& detected);
+    bool registerNewContent(const FrameAnalysis& currentFrame, DetectedFrame& detected);
+    bool reanchorFrame(const FrameAnalysis& currentFrame, int effTop, int effHeight);
+    void resetRegistration(const FrameAnalysis& baseFrame);
+    static void fillContentSignature(const FrameAnalysis& frame, const QRect& rows, ContentSignature& signature);
+    bool screenNewContent(const DetectedFrame& detected, GlobalContentRegion& segment);
+    void startCaptureThread();
+    void stopCaptureThread();
+    // 拼接流水线：检测 -> 去重 -> 合成，各阶段一个线程，合成结果按顺序提交到 GUI 线程
+    void startPipeline();
+    void stopPipeline();
+    void runDetectStage();
+    void runDedupStage();
+    void runComposeStage();
+    void commitComposedSegments(const QList<GlobalContentRegion>& segments, const QImage& preview);
+    void scheduleNextCapture(int effectiveHeight);
+    void requestCaptureInterval(int intervalMs);
+    void applyCaptureInterval(int intervalMs);
+    bool isFrameUnchanged(const QImage& frame, qint64 timestampMs);
 
     QTimer* m_detectionTimer;
     QScreen* m_primaryScreen;
+    QScreen* m_captureScreen;           // 选区所在的屏幕
+    CaptureBackend* m_captureBackend;   // 当前截图后端（拥有所有权）
+    CaptureBackend* m_suspendedBackend = nullptr;  // 回放期间暂存的实时后端
+    
+    // 会话录制/回放
+    SessionRecorder m_recorder;
+    QString m_recordingPath;
+    bool m_replayRealTime = false;      // 按原始时间间隔回放，否则尽快回放
+    QElapsedTimer m_replayClock;
+    
+    // 截图线程：生产者抓屏写入环形队列，processStitchingQueue 消费
+    FrameRing<CaptureTask> m_frameRing;
+    QThread* m_captureThread = nullptr;
+    CaptureWorker* m_captureWorker = nullptr;
+    bool m_useCaptureThread = true;
+    
+    // 拼接流水线。运行期间各阶段独占自己的状态：
+    //   检测线程 - m_lastFrame；去重线程 - 覆盖区域、滚动位置、全局边界、重复计数；
+    //   合成线程 - 长图画布 m_canvas；GUI 线程 - m_globalRegions（按顺序提交）与预览图 m_previewImage
+    //   （画布内部加锁，GUI 线程随时可以读取预览或导出）
+    StageWakeup m_detectWakeup;
+    StageQueue<DetectedFrame> m_dedupQueue;
+    StageQueue<GlobalContentRegion> m_composeQueue;
+    QThread* m_detectThread = nullptr;
+    QThread* m_dedupThread = nullptr;
+    QThread* m_composeThread = nullptr;
+    bool m_usePipeline = true;
     
     QRect m_captureRect;
-    QPixmap m_lastScreenshot;
+    FrameAnalysis m_lastFrame;  // 上一帧及其分析结果（灰度、金字塔、行哈希、行方差）
     QPixmap m_baseImage;        // 基础图片（第一张或当前完整图片）
     QList<QPixmap> m_newContents;  // 新内容片段
     QList<ContentSegment> m_segments;  // 片段拼接信息
-    QList<GlobalContentRegion> m_globalRegions;  // 全局内容区域
-    QList<CoveredRegion> m_coveredRegions;  // 已覆盖区域记录
-    QPixmap m_combinedImage;
+    QList<GlobalContentRegion> m_globalRegions;  // 全局内容区域（只有位置信息，像素在 m_canvas 中）
+    // 增量维护的分块长图画布（流水线运行时只有合成线程写入）
+    QSharedPointer<StitchCanvas> m_canvas = QSharedPointer<StitchCanvas>::create();
+    qint64 m_canvasMemoryBudget = 0;  // 新画布的常驻内存预算（字节）
+    int m_regionOrder = 0;    // 全局区域的截取顺序（流水线中先于提交分配）
+    QList<CoveredRegion> m_coveredRegions;  // 已覆盖区域记录（按 regionId 递增排列）
+    HammingIndex m_coveredHashIndex;        // 已覆盖区域感知哈希的汉明距离索引（value 为 regionId）
+    IntervalIndex m_coveredYIndex;          // 已覆盖区域逻辑 Y 范围的区间索引（value 为 regionId）
+    int m_nextCoveredRegionId = 0;
+    int m_hashIndexHitCount = 0;            // 通过感知哈希索引判定为重复的次数
+    QPixmap m_previewImage;   // 最近一次的长图预览
     
     // 全局坐标系管理
     QRect m_globalBounds;     // 全局内容的边界
@@ -194,6 +355,8 @@ private:
      static const int MIN_NEW_CONTENT_HEIGHT = 10;       // 最小新内容高度（允许较小的滚动）
      static const int MIN_OVERLAP_HEIGHT = 10;           // 最小重叠高度
      static const int MAX_ALLOWED_DUPLICATES = 3;        // 最大允许连续重复次数
+     static const int FRAME_RING_CAPACITY = 8;           // 截图环形队列容量（满时丢弃最旧帧）
+     static const int PIPELINE_STAGE_CAPACITY = 4;       // 流水线阶段间队列容量（满时阻塞上游）
 
     // 新增方法
     void enableAdvancedStitching(bool enabled);
@@ -204,9 +367,9 @@ private:
     TemplateMatchResult performTemplateMatching(const cv::Mat& sourceImage, 
                                               const cv::Mat& templateImage);
     cv::Mat qImageToCvBgr(const QImage& qImage) const;
-    cv::Mat qImageToCvMat(const QImage& qImage);
+    cv::Mat qImageToCvMat(const QImage& qImage) const;
     QImage cvMatToQImage(const cv::Mat& cvMat);
-    FixedRegion detectFixedRegions(const QImage& image);
+    FixedRegion detectFixedRegions(const FrameAnalysis& frame);
     QImage cropFixedRegions(const QImage& image, const FixedRegion& regions);
     QImage restoreFixedRegions(const QImage& stitchedImage, const FixedRegion& regions, 
                               const QImage& topRegion, const QImage& bottomRegion);
@@ -218,13 +381,60 @@ private:
 
     // 新增成员变量
     bool m_useAdvancedStitching = true;      // 是否启用 OpenCV 模板匹配
+    ScrollMatcher m_scrollMatcher = ScrollMatcher::RowSignature;
+    int m_rowMatchCount = 0;                 // 行签名直接给出结果的次数
+    int m_rowMatchFallbackCount = 0;         // 行签名不确定、回退模板匹配的次数
+    int m_pyramidMatchCount = 0;             // 金字塔粗定位 + 局部精匹配成功的次数
+    int m_pyramidFallbackCount = 0;          // 粗定位失败、全分辨率重新搜索的次数
+    ScrollMotionModel m_motionModel;         // 滚动速度模型（与 m_lastFrame 同属检测阶段）
+    int m_motionHitCount = 0;                // 预测窗口内直接命中的次数
+    int m_motionMissCount = 0;               // 预测窗口未命中、扩大搜索的次数
+    CaptureScheduler m_captureScheduler;     // 按滚动速度安排下一次抓取（与运动模型同属检测阶段）
+    bool m_adaptiveCapture = true;
+    bool m_scheduleActive = false;           // 本次会话是否启用调度（只在阶段线程启动前/停止后修改）
+    quint64 m_lastGrabHash = 0;              // 上一次抓取帧的抽样行哈希（检测阶段）
+    qint64 m_lastGrabTimestampMs = -1;       // 上一次抓取帧的时间戳（检测阶段）
+    int m_unchangedFrameCount = 0;           // 因画面未变化而跳过检测的帧数
+    cv::Mat m_phaseWindow;                   // 相位相关使用的 Hanning 窗（按有效区域尺寸缓存）
     double m_templateMatchThreshold = 0.80;  // 模板匹配阈值
     FixedRegion m_fixedRegions;              // 固定区域配置
     
+    // 位置配准（检测阶段独占）：长图逻辑坐标以基础帧第 0 行为原点
+    bool m_useRegistration = true;
+    int m_viewportY = 0;                     // 上一帧第 0 行在长图中的逻辑 Y
+    int m_canvasTop = 0;                     // 长图已覆盖的滚动内容范围 [m_canvasTop, m_canvasBottom)
+    int m_canvasBottom = 0;
+    int m_registeredAppendCount = 0;         // 配准后追加新行的次数
+    int m_registeredCoveredCount = 0;        // 配准后所有行都已覆盖、直接跳过的次数
+    int m_registrationMisses = 0;            // 连续无法与上一帧配准的次数
+    CanvasIndex m_canvasIndex;               // 长图的缩小灰度索引（跟丢后重新定位用）
+    int m_reanchorCount = 0;                 // 重新定位成功的次数
+    int m_reanchorFailCount = 0;             // 重新定位失败的次数
+    
     // OpenCV 相关常量
     static const int TEMPLATE_HEIGHT = 50;   // 模板高度（行数）
     static constexpr double DEFAULT_MATCH_THRESHOLD = 0.8;  // 默认匹配阈值
     static const int FIXED_REGION_DETECTION_HEIGHT = 100;   // 固定区域检测高度
+    
+    // 行签名对齐参数
+    static const int ROW_SIGNATURE_MIN_VOTES = 8;           // 最佳位移至少需要的唯一行投票数
+    static constexpr double ROW_SIGNATURE_MIN_CONFIDENCE = 0.9;  // 重叠区域内行哈希一致的最低比例
+    
+    static const int PYRAMID_MIN_TEMPLATE_ROWS = 8;         // 粗匹配层上模板至少保留的行数
+    
+    // 相位相关参数
+    static constexpr double PHASE_MIN_RESPONSE = 0.1;       // 相关峰能量占比下限（低于此值视为没有可靠峰值）
+    static constexpr double PHASE_MAX_HORIZONTAL_SHIFT = 1.5;  // 允许的水平位移（像素），超过说明不是纵向滚动
+    
+    // 感知哈希去重参数（64 位 dHash 的汉明距离）
+    static const int PHASH_MATCH_DISTANCE = 6;      // 不论位置，距离不超过此值的已覆盖内容作为重复候选
+    static const int PHASH_SIMILAR_DISTANCE = 20;   // 位置重叠的区域距离超过此值时不再做像素比较
+    
+    // 跟丢后重新定位参数
+    static const int REANCHOR_MISSES = 3;               // 连续多少帧无法配准后在整张长图中重新定位
+    static constexpr double REANCHOR_MIN_SCORE = 0.9;   // 重新定位的最低匹配得分
+    static constexpr double REANCHOR_MIN_MARGIN = 0.05; // 重新定位时最高峰至少高出次高峰的得分（排除重复内容上的误定位）
+    static constexpr double REANCHOR_MIN_STDDEV = 8.0;  // 参与定位的行灰度标准差下限（排除空白区域）
 };
 
 #endif // SCREENSHOTCAPTURE_H
\ No newline at end of file
@@ -11,6 +11,10 @@ ScreenshotPreview::ScreenshotPreview(QWidget *parent)
     , m_imageLabel(nullptr)
     , m_infoLabel(nullptr)
     , m_progressBar(nullptr)
+    , m_exportPanel(nullptr)
+    , m_exportLabel(nullptr)
+    , m_exportProgressBar(nullptr)
+    , m_cancelExportButton(nullptr)
     , m_isCapturing(false)
     , m_imageCount(0)
 {
@@ -56,6 +60,20 @@ void ScreenshotPreview::setupUI()
     m_progressBar = new QProgressBar(this);
     m_progressBar->setVisible(false);
     
+    // 后台导出进度：文件名 + 进度条 + 取消按钮，没有导出任务时隐藏
+    m_exportPanel = new QWidget(this);
+    QHBoxLayout* exportLayout = new QHBoxLayout(m_exportPanel);
+    exportLayout->setContentsMargins(0, 0, 0, 0);
+    m_exportLabel = new QLabel(m_exportPanel);
+    m_exportProgressBar = new QProgressBar(m_exportPanel);
+    m_exportProgressBar->setRange(0, 100);
+    m_cancelExportButton = new QPushButton("取消导出", m_exportPanel);
+    connect(m_cancelExportButton, &QPushButton::clicked, this, &ScreenshotPreview::exportCancelRequested);
+    exportLayout->addWidget(m_exportLabel);
+    exportLayout->addWidget(m_exportProgressBar, 1);
+    exportLayout->addWidget(m_cancelExportButton);
+    m_exportPanel->setVisible(false);
+    
     // 滚动区域
     m_scrollArea = new QScrollArea(this);
     m_scrollArea->setWidgetResizable(true);
@@ -78,6 +96,7 @@ void ScreenshotPreview::setupUI()
     // 主布局 - 移除按钮布局
     m_mainLayout->addWidget(m_infoLabel);
     m_mainLayout->addWidget(m_progressBar);
+    m_mainLayout->addWidget(m_exportPanel);
     m_mainLayout->addWidget(m_scrollArea);
     
     // 不再创建和连接按钮
@@ -120,7 +139,7 @@ void ScreenshotPreview::updatePreview(const QList<QPixmap>& images)
     m_infoLabel->setText(QString("已捕获 %1 张图片").arg(m_imageCount));
 }
 
-void ScreenshotPreview::updateRealTimePreview(const QPixmap& image)
+void ScreenshotPreview::updateRealTimePreview(const QPixmap& image, const QSize& fullSize)
 {
     if (!image.isNull()) {
         // 缩放图片以适应预览，但保持原始尺寸信息
@@ -131,14 +150,15 @@ void ScreenshotPreview::updateRealTimePreview(const QPixmap& image)
         m_imageLabel->resize(scaledImage.size());
         
         // 更新信息标签显示实时进度
-        m_infoLabel->setText(QString("实时预览 - 当前尺寸: %1x%2").arg(image.width()).arg(image.height()));
+        const QSize size = fullSize.isValid() ? fullSize : image.size();
+        m_infoLabel->setText(QString("实时预览 - 当前尺寸: %1x%2").arg(size.width()).arg(size.height()));
         
         // 在实时预览期间，启用保存按钮
         // m_saveButton->setEnabled(true); // This line is removed as per the edit hint
     }
 }
 
-void ScreenshotPreview::setFinalImage(const QPixmap& image)
+void ScreenshotPreview::setFinalImage(const QPixmap& image, const QSize& fullSize)
 {
     m_finalImage = image;
     m_isCapturing = false;
@@ -151,7 +171,8 @@ void ScreenshotPreview::setFinalImage(const QPixmap& image)
         m_imageLabel->setPixmap(scaledImage);
         m_imageLabel->resize(scaledImage.size());
         
-        m_infoLabel->setText(QString("截图完成！尺寸: %1x%2").arg(image.width()).arg(image.height()));
+        const QSize size = fullSize.isValid() ? fullSize : image.size();
+        m_infoLabel->setText(QString("截图完成！尺寸: %1x%2").arg(size.width()).arg(size.height()));
         
         // 确保保存按钮在最终完成时也是启用的
         // m_saveButton->setEnabled(true); // This line is removed as per the edit hint
@@ -173,6 +194,24 @@ void ScreenshotPreview::clearPreview()
     updateButtons();
 }
 
+void ScreenshotPreview::setExportStarted(const QString& fileName, int queuedJobs)
+{
+    m_exportLabel->setText(queuedJobs > 0 ? QString("正在导出 %1（另有 %2 个排队）").arg(fileName).arg(queuedJobs)
+                                          : QString("正在导出 %1").arg(fileName));
+    m_exportProgressBar->setValue(0);
+    m_exportPanel->setVisible(true);
+}
+
+void ScreenshotPreview::setExportProgress(int percent)
+{
+    m_exportProgressBar->setValue(percent);
+}
+
+void ScreenshotPreview::setExportFinished()
+{
+    m_exportPanel->setVisible(false);
+}
+
 void ScreenshotPreview::updateImageDisplay()
 {
     if (m_capturedImages.isEmpty()) {
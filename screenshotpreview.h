@@ -23,13 +23,19 @@ public:
     void showPreview(const QRect& captureRect);
     void hidePreview();
     void updatePreview(const QList<QPixmap>& images);
-    void updateRealTimePreview(const QPixmap& image);
-    void setFinalImage(const QPixmap& image);
+    // image 可以是缩小后的预览图，fullSize 为长图的实际尺寸（为空时使用 image 的尺寸）
+    void updateRealTimePreview(const QPixmap& image, const QSize& fullSize = QSize());
+    void setFinalImage(const QPixmap& image, const QSize& fullSize = QSize());
     void clearPreview();
+    // 后台导出进度（与截图进度条分开显示，截图进行中也可以同时导出）
+    void setExportStarted(const QString& fileName, int queuedJobs);
+    void setExportProgress(int percent);
+    void setExportFinished();
 
 signals:
     void saveRequested();
     void closeRequested();
+    void exportCancelRequested();
 
 private:
     void setupUI();
@@ -43,6 +49,10 @@ private:
     QLabel* m_imageLabel;
     QLabel* m_infoLabel;
     QProgressBar* m_progressBar;
+    QWidget* m_exportPanel;
+    QLabel* m_exportLabel;
+    QProgressBar* m_exportProgressBar;
+    QPushButton* m_cancelExportButton;
     
     QList<QPixmap> m_capturedImages;
     QPixmap m_finalImage;
@@ -0,0 +1,48 @@
+#include "scrollmotionmodel.h"
+#include <cmath>
+
+const int ScrollMotionModel::MIN_RADIUS;
+
+void ScrollMotionModel::reset()
+{
+    m_velocity = 0.0;
+    m_acceleration = 0.0;
+    m_errorPx = 0.0;
+    m_samples = 0;
+}
+
+void ScrollMotionModel::update(int displacement, qint64 intervalMs)
+{
+    // 回放或连续快速抓取时时间戳可能相同，按 1ms 处理避免除零
+    const double dt = double(qMax<qint64>(1, intervalMs));
+    const double measured = displacement / dt;
+
+    if (m_samples == 0) {
+        m_velocity = measured;
+        m_acceleration = 0.0;
+        m_samples = 1;
+        return;
+    }
+
+    const double predictedVelocity = m_velocity + m_acceleration * dt;
+    const double residual = measured - predictedVelocity;
+    m_velocity = predictedVelocity + ALPHA * residual;
+    m_acceleration += BETA * residual / dt;
+
+    const double errorPx = std::abs(residual * dt);
+    m_errorPx = (m_samples == 1) ? errorPx : m_errorPx + ERROR_SMOOTHING * (errorPx - m_errorPx);
+    m_samples++;
+}
+
+void ScrollMotionModel::markMiss()
+{
+    // 加倍误差估计，下次预测的窗口随之变宽
+    m_errorPx = qMax(double(MIN_RADIUS), m_errorPx * 2.0);
+}
+
+void ScrollMotionModel::predict(qint64 intervalMs, int& displacement, int& radius) const
+{
+    const double dt = double(qMax<qint64>(1, intervalMs));
+    displacement = static_cast<int>(std::lround((m_velocity + m_acceleration * dt) * dt));
+    radius = qMax(MIN_RADIUS, static_cast<int>(std::ceil(3.0 * m_errorPx)) + 2);
+}
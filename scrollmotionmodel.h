@@ -0,0 +1,40 @@
+#ifndef SCROLLMOTIONMODEL_H
+#define SCROLLMOTIONMODEL_H
+
+#include <QtGlobal>
+
+// 滚动运动模型（alpha-beta 滤波）：
+// 用最近几次测得的位移和帧间隔估计滚动速度及其变化趋势，预测下一对帧之间的位移，
+// 并根据最近的预测误差给出搜索窗口半径。连续帧的滚动高度相关，多数情况下只需搜索窗口内的几十行。
+class ScrollMotionModel
+{
+public:
+    void reset();
+
+    // 记录一次测量：intervalMs 内内容移动了 displacement 像素（带符号）
+    void update(int displacement, qint64 intervalMs);
+    // 本次预测窗口内没有找到匹配，增大不确定度
+    void markMiss();
+
+    // 至少有两次测量后才给出预测
+    bool hasPrediction() const { return m_samples >= 2; }
+    // 预测 intervalMs 后的位移及搜索半径（像素）
+    void predict(qint64 intervalMs, int& displacement, int& radius) const;
+
+    // 当前速度（像素/毫秒，带符号），供截图调度使用
+    double velocity() const { return m_velocity; }
+    int sampleCount() const { return m_samples; }
+
+    static const int MIN_RADIUS = 12;           // 最小搜索半径（像素）
+    static constexpr double ALPHA = 0.5;        // 速度修正系数
+    static constexpr double BETA = 0.1;         // 加速度修正系数
+    static constexpr double ERROR_SMOOTHING = 0.3;  // 预测误差的指数平滑系数
+
+private:
+    double m_velocity = 0.0;        // 像素/毫秒
+    double m_acceleration = 0.0;    // 像素/毫秒²
+    double m_errorPx = 0.0;         // 平滑后的预测误差（像素）
+    int m_samples = 0;
+};
+
+#endif // SCROLLMOTIONMODEL_H
@@ -0,0 +1,464 @@
+#include "stitchcanvas.h"
+#include <QDebug>
+#include <QDir>
+#include <QPainter>
+#include <QTemporaryFile>
+#include <cstring>
+
+const int StitchCanvas::TILE_HEIGHT;
+const int StitchCanvas::PREVIEW_SCALE;
+const int StitchCanvas::PREVIEW_MAX_HEIGHT;
+const int StitchCanvas::SPILL_GROW_SLOTS;
+
+StitchCanvas::~StitchCanvas()
+{
+    releaseSpillFile();
+}
+
+void StitchCanvas::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_tiles.clear();
+    m_left = 0;
+    m_width = 0;
+    m_bounds = QRect();
+    m_clock = 0;
+    m_residentTiles = 0;
+    releaseSpillFile();
+    m_spillFailed = false;
+}
+
+void StitchCanvas::setMemoryBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_memoryBudget = qMax<qint64>(0, bytes);
+    enforceBudget();
+}
+
+int StitchCanvas::tileIndexFor(int logicalY)
+{
+    // 向下取整，负坐标（向上滚动追加的内容）同样适用
+    return logicalY >= 0 ? logicalY / TILE_HEIGHT : -((-logicalY + TILE_HEIGHT - 1) / TILE_HEIGHT);
+}
+
+qint64 StitchCanvas::tileBytes() const
+{
+    return qint64(m_width) * 4 * TILE_HEIGHT;
+}
+
+int StitchCanvas::thumbnailWidth() const
+{
+    return qMax(1, m_width / PREVIEW_SCALE);
+}
+
+qint64 StitchCanvas::thumbnailBytes() const
+{
+    return qint64(thumbnailWidth()) * 4 * (TILE_HEIGHT / PREVIEW_SCALE);
+}
+
+// 换出文件的槽位：图块像素之后紧跟它的预览缩略图
+qint64 StitchCanvas::slotBytes() const
+{
+    return tileBytes() + thumbnailBytes();
+}
+
+// 取得可写的图块：不存在则新建，已换出则换回内存
+StitchCanvas::Tile& StitchCanvas::writableTile(int index)
+{
+    auto it = m_tiles.find(index);
+    if (it == m_tiles.end()) {
+        Tile tile;
+        tile.image = QImage(m_width, TILE_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+        tile.image.fill(Qt::transparent);
+        it = m_tiles.insert(index, tile);
+        ++m_residentTiles;
+    } else if (it->spilled) {
+        it->image = tileView(it.value()).copy();
+        it->spilled = false;
+        it->thumbnailDirty = true;
+        ++m_residentTiles;
+    }
+    return it.value();
+}
+
+const uchar* StitchCanvas::tileRow(const Tile& tile, int row) const
+{
+    if (tile.spilled) {
+        return m_spillMap + tile.slot * slotBytes() + qint64(row) * m_width * 4;
+    }
+    return tile.image.constScanLine(row);
+}
+
+// 图块的只读视图：换出的图块直接包装映射内存，不换回内存
+QImage StitchCanvas::tileView(const Tile& tile) const
+{
+    if (!tile.spilled) {
+        return tile.image;
+    }
+    return QImage(tileRow(tile, 0), m_width, TILE_HEIGHT, m_width * 4, QImage::Format_ARGB32_Premultiplied);
+}
+
+// 预览缩略图：常驻图块缓存在内存中，换出的图块直接读写槽位末尾的映射，都只在图块有变化后重算
+QImage StitchCanvas::tileThumbnail(Tile& tile)
+{
+    const int thumbHeight = TILE_HEIGHT / PREVIEW_SCALE;
+    if (!tile.spilled) {
+        if (tile.thumbnailDirty || tile.thumbnail.isNull()) {
+            tile.thumbnail = tile.image.scaled(thumbnailWidth(), thumbHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            tile.thumbnailDirty = false;
+        }
+        return tile.thumbnail;
+    }
+
+    uchar* bits = m_spillMap + tile.slot * slotBytes() + tileBytes();
+    QImage mapped(bits, thumbnailWidth(), thumbHeight, thumbnailWidth() * 4, QImage::Format_ARGB32_Premultiplied);
+    if (tile.thumbnailDirty) {
+        const QImage scaled = tileView(tile).scaled(thumbnailWidth(), thumbHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                                  .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < thumbHeight; ++y) {
+            std::memcpy(mapped.scanLine(y), scaled.constScanLine(y), size_t(thumbnailWidth()) * 4);
+        }
+        tile.thumbnailDirty = false;
+    }
+    return mapped;
+}
+
+// 出现更宽的片段时加宽所有图块（截图宽度固定，正常只在第一次绘制时发生）。
+// 槽位大小随宽度变化：已换出的图块在新的换出文件中按新宽度重排，像素不经过内存；
+// 新文件不可用时才把它们换回内存
+void StitchCanvas::widenTo(int left, int right)
+{
+    const int newLeft = m_width > 0 ? qMin(m_left, left) : left;
+    const int newRight = m_width > 0 ? qMax(m_left + m_width, right) : right;
+    if (m_width > 0 && newLeft == m_left && newRight == m_left + m_width) {
+        return;
+    }
+
+    const int oldWidth = m_width;
+    const int dstX = m_left - newLeft;
+    QTemporaryFile* oldFile = m_spillFile;
+    uchar* oldMap = m_spillMap;
+    const qint64 oldSlotBytes = slotBytes();
+    const int slots = m_spillSlots;
+    m_spillFile = nullptr;
+    m_spillMap = nullptr;
+    m_spillSlots = 0;
+    m_spillCapacity = 0;
+
+    m_left = newLeft;
+    m_width = newRight - newLeft;
+    const bool remapped = slots == 0 || ensureSpillCapacity(slots);
+    if (remapped) {
+        m_spillSlots = slots;
+    } else {
+        releaseSpillFile();
+    }
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+        if (it->spilled && remapped) {
+            const uchar* src = oldMap + it->slot * oldSlotBytes;
+            uchar* dst = m_spillMap + it->slot * slotBytes();
+            for (int y = 0; y < TILE_HEIGHT; ++y) {
+                uchar* row = dst + qint64(y) * m_width * 4;
+                std::memset(row, 0, size_t(m_width) * 4);
+                std::memcpy(row + dstX * 4, src + qint64(y) * oldWidth * 4, size_t(oldWidth) * 4);
+            }
+        } else {
+            QImage wider(m_width, TILE_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+            wider.fill(Qt::transparent);
+            for (int y = 0; y < TILE_HEIGHT; ++y) {
+                const uchar* src = it->spilled ? oldMap + it->slot * oldSlotBytes + qint64(y) * oldWidth * 4
+                                               : it->image.constScanLine(y);
+                std::memcpy(wider.scanLine(y) + dstX * 4, src, size_t(oldWidth) * 4);
+            }
+            if (it->spilled) {
+                it->spilled = false;
+                ++m_residentTiles;
+            }
+            it->image = wider;
+            if (!remapped) {
+                it->slot = -1;
+            }
+        }
+        it->thumbnail = QImage();
+        it->thumbnailDirty = true;
+    }
+
+    if (oldFile) {
+        if (oldMap) {
+            oldFile->unmap(oldMap);
+        }
+        delete oldFile;
+    }
+}
+
+void StitchCanvas::blit(const QImage& image, const QPoint& logicalPos)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    // RGB32 与预乘 ARGB32 的内存布局一致，可直接逐行拷贝；但 RGB32 的最高字节不一定是 0xff
+    // （例如 X11 深度 24 的填充字节），拷贝时强制为不透明，与 QPainter 绘制 RGB32 的语义一致
+    const bool opaqueSource = image.format() == QImage::Format_RGB32;
+    const bool sameLayout = opaqueSource || image.format() == QImage::Format_ARGB32_Premultiplied;
+    const QImage src = sameLayout ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QRect logicalRect(logicalPos, src.size());
+
+    QMutexLocker locker(&m_mutex);
+    widenTo(logicalRect.left(), logicalRect.left() + logicalRect.width());
+    ++m_clock;
+
+    const int dstX = logicalRect.x() - m_left;
+    const int rowBytes = src.width() * 4;
+    int y = logicalRect.top();
+    while (y <= logicalRect.bottom()) {
+        const int index = tileIndexFor(y);
+        const int tileTop = index * TILE_HEIGHT;
+        const int rows = qMin(logicalRect.bottom() + 1, tileTop + TILE_HEIGHT) - y;
+        Tile& tile = writableTile(index);
+        for (int i = 0; i < rows; ++i) {
+            uchar* dst = tile.image.scanLine(y - tileTop + i) + dstX * 4;
+            std::memcpy(dst, src.constScanLine(y - logicalRect.top() + i), rowBytes);
+            if (opaqueSource) {
+                quint32* pixels = reinterpret_cast<quint32*>(dst);
+                for (int x = 0; x < src.width(); ++x) {
+                    pixels[x] |= 0xff000000u;
+                }
+            }
+        }
+        tile.thumbnailDirty = true;
+        tile.lastWrite = m_clock;
+        y += rows;
+    }
+
+    m_bounds = m_bounds.isEmpty() ? logicalRect : m_bounds.united(logicalRect);
+    enforceBudget();
+}
+
+// 常驻图块超出预算时，按最久未写入的顺序换出（本次刚写入的图块除外）。
+// 长图只在两端增长，远离当前滚动位置的图块很少再被写入，换出后读取也只走映射
+void StitchCanvas::enforceBudget()
+{
+    if (m_memoryBudget <= 0 || m_spillFailed || m_width <= 0) {
+        return;
+    }
+    const qint64 maxResident = qMax<qint64>(1, m_memoryBudget / slotBytes());
+    while (m_residentTiles > maxResident) {
+        Tile* coldest = nullptr;
+        for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+            if (!it->spilled && it->lastWrite != m_clock && (!coldest || it->lastWrite < coldest->lastWrite)) {
+                coldest = &it.value();
+            }
+        }
+        if (!coldest || !spillTile(*coldest)) {
+            return;
+        }
+    }
+}
+
+bool StitchCanvas::spillTile(Tile& tile)
+{
+    if (tile.slot < 0) {
+        if (!ensureSpillCapacity(m_spillSlots + 1)) {
+            m_spillFailed = true;
+            qDebug() << "⚠️ 长图换出文件不可用，图块保留在内存中";
+            return false;
+        }
+        tile.slot = m_spillSlots++;
+    }
+
+    // 缩略图随像素一起换出；尚未生成的留到预览时从映射中生成
+    uchar* slot = m_spillMap + tile.slot * slotBytes();
+    std::memcpy(slot, tile.image.constBits(), tileBytes());
+    if (!tile.thumbnailDirty && !tile.thumbnail.isNull()) {
+        const QImage thumbnail = tile.thumbnail.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        const int rowBytes = thumbnailWidth() * 4;
+        for (int y = 0; y < thumbnail.height(); ++y) {
+            std::memcpy(slot + tileBytes() + qint64(y) * rowBytes, thumbnail.constScanLine(y), rowBytes);
+        }
+    } else {
+        tile.thumbnailDirty = true;
+    }
+    tile.image = QImage();
+    tile.thumbnail = QImage();
+    tile.spilled = true;
+    --m_residentTiles;
+    return true;
+}
+
+// 换出文件按槽位成倍扩展；扩展时需要重新映射，此前的映射地址随之失效（只在加锁期间使用，不会外泄）
+bool StitchCanvas::ensureSpillCapacity(int slots)
+{
+    if (slots <= m_spillCapacity) {
+        return true;
+    }
+    if (!m_spillFile) {
+        m_spillFile = new QTemporaryFile(QDir::tempPath() + "/rabbitshot-canvas-XXXXXX");
+        if (!m_spillFile->open()) {
+            qDebug() << "❌ 无法创建长图换出文件:" << m_spillFile->errorString();
+            return false;
+        }
+    }
+
+    const int capacity = qMax(slots, qMax(SPILL_GROW_SLOTS, m_spillCapacity * 2));
+    const qint64 size = capacity * slotBytes();
+    if (m_spillMap) {
+        m_spillFile->unmap(m_spillMap);
+        m_spillMap = nullptr;
+    }
+    if (!m_spillFile->resize(size)) {
+        qDebug() << "❌ 长图换出文件扩展失败:" << m_spillFile->errorString();
+        return false;
+    }
+    m_spillMap = m_spillFile->map(0, size);
+    if (!m_spillMap) {
+        qDebug() << "❌ 长图换出文件映射失败:" << m_spillFile->errorString();
+        return false;
+    }
+    m_spillCapacity = capacity;
+    qDebug() << "💾 长图换出文件扩展到" << (size / (1024 * 1024)) << "MB:" << m_spillFile->fileName();
+    return true;
+}
+
+void StitchCanvas::releaseSpillFile()
+{
+    if (m_spillFile) {
+        if (m_spillMap) {
+            m_spillFile->unmap(m_spillMap);
+        }
+        delete m_spillFile;  // QTemporaryFile 析构时删除文件
+    }
+    m_spillFile = nullptr;
+    m_spillMap = nullptr;
+    m_spillSlots = 0;
+    m_spillCapacity = 0;
+}
+
+bool StitchCanvas::isEmpty() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bounds.isEmpty();
+}
+
+QRect StitchCanvas::bounds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bounds;
+}
+
+QImage StitchCanvas::copyRegion(const QRect& logicalRect) const
+{
+    QMutexLocker locker(&m_mutex);
+    return copyRegionLocked(logicalRect);
+}
+
+QImage StitchCanvas::copyRegionLocked(const QRect& logicalRect) const
+{
+    if (logicalRect.isEmpty()) {
+        return QImage();
+    }
+    QImage result(logicalRect.size(), QImage::Format_ARGB32_Premultiplied);
+    if (result.isNull()) {
+        qDebug() << "❌ 长图区域分配失败:" << logicalRect.size();
+        return result;
+    }
+    result.fill(Qt::transparent);
+
+    // 只拷贝与区域横向相交的部分
+    const int left = qMax(logicalRect.left(), m_left);
+    const int right = qMin(logicalRect.left() + logicalRect.width(), m_left + m_width);
+    if (right <= left) {
+        return result;
+    }
+    const int rowBytes = (right - left) * 4;
+    const int srcX = left - m_left;
+    const int dstX = left - logicalRect.left();
+
+    int y = logicalRect.top();
+    while (y <= logicalRect.bottom()) {
+        const int index = tileIndexFor(y);
+        const int tileTop = index * TILE_HEIGHT;
+        const int rows = qMin(logicalRect.bottom() + 1, tileTop + TILE_HEIGHT) - y;
+        auto it = m_tiles.constFind(index);
+        if (it != m_tiles.constEnd()) {
+            for (int i = 0; i < rows; ++i) {
+                std::memcpy(result.scanLine(y - logicalRect.top() + i) + dstX * 4,
+                            tileRow(it.value(), y - tileTop + i) + srcX * 4, rowBytes);
+            }
+        }
+        y += rows;
+    }
+    return result;
+}
+
+void StitchCanvas::readRow(int logicalY, int left, int width, uchar* dst) const
+{
+    std::memset(dst, 0, size_t(width) * 4);
+
+    QMutexLocker locker(&m_mutex);
+    const int from = qMax(left, m_left);
+    const int to = qMin(left + width, m_left + m_width);
+    const int index = tileIndexFor(logicalY);
+    auto it = m_tiles.constFind(index);
+    if (to <= from || it == m_tiles.constEnd()) {
+        return;
+    }
+    std::memcpy(dst + (from - left) * 4, tileRow(it.value(), logicalY - index * TILE_HEIGHT) + (from - m_left) * 4, (to - from) * 4);
+}
+
+QImage StitchCanvas::image() const
+{
+    QMutexLocker locker(&m_mutex);
+    return copyRegionLocked(m_bounds);
+}
+
+QImage StitchCanvas::preview(int maxHeight)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_bounds.isEmpty()) {
+        return QImage();
+    }
+
+    // 结果尺寸：整体缩小 PREVIEW_SCALE 倍，超过 maxHeight 时再按比例缩小
+    const int previewWidth = qMax(1, m_bounds.width() / PREVIEW_SCALE);
+    const int previewHeight = qMax(1, m_bounds.height() / PREVIEW_SCALE);
+    const double fit = previewHeight > maxHeight ? double(maxHeight) / previewHeight : 1.0;
+    QImage result(qMax(1, int(previewWidth * fit)), qMax(1, int(previewHeight * fit)), QImage::Format_ARGB32_Premultiplied);
+    result.fill(Qt::transparent);
+
+    const int firstTile = tileIndexFor(m_bounds.top());
+    const int lastTile = tileIndexFor(m_bounds.bottom());
+
+    // 在逻辑坐标中绘制每个图块的缩略图，由变换完成缩放和裁剪
+    QPainter painter(&result);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.scale(fit / PREVIEW_SCALE, fit / PREVIEW_SCALE);
+    painter.translate(-m_bounds.left(), -m_bounds.top());
+    for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+        if (it.key() < firstTile || it.key() > lastTile) {
+            continue;
+        }
+        painter.drawImage(QRectF(m_left, it.key() * TILE_HEIGHT, m_width, TILE_HEIGHT), tileThumbnail(it.value()));
+    }
+    painter.end();
+    return result;
+}
+
+int StitchCanvas::tileCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_tiles.size();
+}
+
+int StitchCanvas::spilledTileCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_tiles.size() - m_residentTiles;
+}
+
+qint64 StitchCanvas::allocatedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_residentTiles * slotBytes();
+}
@@ -0,0 +1,97 @@
+#ifndef STITCHCANVAS_H
+#define STITCHCANVAS_H
+
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QRect>
+
+class QTemporaryFile;
+
+// 增量维护的分块长图画布：逻辑坐标按固定高度（TILE_HEIGHT 行）切成图块，新片段逐行拷贝进所覆盖的图块。
+// 不再存在覆盖整张长图的单个 QImage：内存随内容按图块线性增长，长页面在 HiDPI 下也不会碰到
+// 单幅图像的尺寸上限或一次性分配数 GB 内存；任意区域、预览缩略图都只访问相关图块即可得到。
+// 设置内存预算后，超出预算时最久未写入的图块连同预览缩略图一起换出到内存映射的临时文件，
+// 读取和绘制预览时直接访问映射，再次写入时才换回内存，因此常驻内存与截图长度无关。
+// 所有接口内部加锁，合成线程写入的同时 GUI 线程可以读取预览或导出。
+class StitchCanvas
+{
+public:
+    StitchCanvas() = default;
+    ~StitchCanvas();
+
+    void reset();
+    // 常驻图块（含缩略图）的内存预算（字节），0 表示不限制
+    void setMemoryBudget(qint64 bytes);
+    // 把 image 放到逻辑坐标 logicalPos 处（后加入的内容覆盖先前的内容）
+    void blit(const QImage& image, const QPoint& logicalPos);
+
+    bool isEmpty() const;
+    // 已绘制内容的逻辑边界
+    QRect bounds() const;
+    // 取出任意逻辑区域（只拷贝相交的图块，未绘制处透明）
+    QImage copyRegion(const QRect& logicalRect) const;
+    // 读取一行逻辑像素 [left, left + width) 到 dst（32 位预乘 ARGB，未绘制处透明），供流式导出逐行使用
+    void readRow(int logicalY, int left, int width, uchar* dst) const;
+    // 取出全部内容（会分配整张长图，仅用于确实需要完整图像的场合）
+    QImage image() const;
+    // 预览图：每个图块缩小 PREVIEW_SCALE 倍（缩略图按图块缓存，只重算有变化的图块），
+    // 直接绘制到高度不超过 maxHeight 的结果中
+    QImage preview(int maxHeight = PREVIEW_MAX_HEIGHT);
+
+    int tileCount() const;
+    int spilledTileCount() const;
+    // 常驻内存的图块与缩略图字节数
+    qint64 allocatedBytes() const;
+
+    static const int TILE_HEIGHT = 256;             // 图块高度（行）
+    static const int PREVIEW_SCALE = 4;             // 预览缩略图的缩小倍数
+    static const int PREVIEW_MAX_HEIGHT = 8192;     // 预览图的最大高度
+    static const int SPILL_GROW_SLOTS = 64;         // 换出文件每次至少扩展的图块槽位数
+
+private:
+    struct Tile {
+        QImage image;           // 常驻时的像素：TILE_HEIGHT 行 x 画布宽度，ARGB32_Premultiplied，未绘制处透明
+        int slot = -1;          // 换出文件中的槽位（首次换出时分配，之后固定）
+        bool spilled = false;   // 像素当前只在换出文件中
+        quint64 lastWrite = 0;  // 最近一次写入时的 m_clock
+        QImage thumbnail;       // 预览缩略图缓存（仅常驻图块；换出后缩略图存放在槽位末尾）
+        bool thumbnailDirty = true;
+    };
+
+    static int tileIndexFor(int logicalY);
+    qint64 tileBytes() const;
+    int thumbnailWidth() const;
+    qint64 thumbnailBytes() const;
+    qint64 slotBytes() const;
+    Tile& writableTile(int index);
+    const uchar* tileRow(const Tile& tile, int row) const;
+    QImage tileView(const Tile& tile) const;
+    QImage tileThumbnail(Tile& tile);
+    void widenTo(int left, int right);
+    QImage copyRegionLocked(const QRect& logicalRect) const;
+    void enforceBudget();
+    bool spillTile(Tile& tile);
+    bool ensureSpillCapacity(int slots);
+    void releaseSpillFile();
+
+    mutable QMutex m_mutex;
+    QMap<int, Tile> m_tiles;    // 图块序号 -> 图块，第 i 块覆盖逻辑行 [i * TILE_HEIGHT, (i + 1) * TILE_HEIGHT)
+    int m_left = 0;             // 图块第 0 列对应的逻辑 X
+    int m_width = 0;            // 图块宽度
+    QRect m_bounds;
+    quint64 m_clock = 0;        // 每次 blit 递增，用于挑选最久未写入的图块
+
+    // 换出文件
+    qint64 m_memoryBudget = 0;
+    int m_residentTiles = 0;
+    QTemporaryFile* m_spillFile = nullptr;
+    uchar* m_spillMap = nullptr;
+    int m_spillSlots = 0;       // 已分配的槽位数
+    int m_spillCapacity = 0;    // 文件当前能容纳的槽位数
+    bool m_spillFailed = false; // 临时文件创建或映射失败后不再尝试换出
+
+    Q_DISABLE_COPY(StitchCanvas)
+};
+
+#endif // STITCHCANVAS_H
@@ -0,0 +1,133 @@
+#ifndef STITCHINGPIPELINE_H
+#define STITCHINGPIPELINE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QList>
+#include <QWaitCondition>
+
+// 拼接流水线的阶段间队列：有界、阻塞、先进先出。
+// 已经检测出的新内容不能丢弃，所以队列满时阻塞上游阶段（反压），而不是像截图环形队列那样丢弃旧帧。
+// close() 之后 push 失败，pop 会先取完剩余数据再返回 false，用于按顺序排空流水线。
+template <typename T>
+class StageQueue
+{
+public:
+    explicit StageQueue(int capacity) : m_capacity(qMax(1, capacity)) {}
+
+    bool push(const T& item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_closed && m_items.size() >= m_capacity) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_closed) {
+            return false;
+        }
+        m_items.enqueue(item);
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_closed && m_items.isEmpty()) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_items.isEmpty()) {
+            return false;
+        }
+        item = m_items.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    // 一次取出当前所有数据（至少一项），用于可以合并处理的阶段
+    bool popAll(QList<T>& items)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_closed && m_items.isEmpty()) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_items.isEmpty()) {
+            return false;
+        }
+        items.clear();
+        while (!m_items.isEmpty()) {
+            items.append(m_items.dequeue());
+        }
+        m_notFull.wakeAll();
+        return true;
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    void reset()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_items.clear();
+        m_closed = false;
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<T> m_items;
+    int m_capacity;
+    bool m_closed = false;
+};
+
+// 轻量唤醒信号：生产者 notify()，消费者 wait() 直到有通知或被关闭。
+// 通知会被记住，消费者检查数据与进入等待之间的通知不会丢失。
+class StageWakeup
+{
+public:
+    void notify()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending = true;
+        m_condition.wakeOne();
+    }
+
+    // 返回 false 表示已关闭
+    bool wait()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_pending && !m_closed) {
+            m_condition.wait(&m_mutex);
+        }
+        m_pending = false;
+        return !m_closed;
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_condition.wakeAll();
+    }
+
+    void reset()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending = false;
+        m_closed = false;
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    bool m_pending = false;
+    bool m_closed = false;
+};
+
+#endif // STITCHINGPIPELINE_H
@@ -0,0 +1,77 @@
+#include "pixelkernels.h"
+#include <QRandomGenerator>
+#include <QVector>
+#include <QtTest>
+
+// 像素比较内核的对照测试：本机支持的每个 SIMD 实现都必须与标量实现给出完全相同的结果，
+// 包括长度不是 SIMD 宽度整数倍时由标量代码处理的尾部
+class PixelKernelsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void countSimilarMatchesScalar_data();
+    void countSimilarMatchesScalar();
+
+private:
+    static void makeRows(QRandomGenerator& random, int count, int maxDelta, QVector<quint32>& a, QVector<quint32>& b);
+};
+
+// b 在 a 的基础上每个通道随机偏移至多 maxDelta，alpha 完全随机（内核只比较 RGB）
+void PixelKernelsTest::makeRows(QRandomGenerator& random, int count, int maxDelta, QVector<quint32>& a, QVector<quint32>& b)
+{
+    a.resize(count);
+    b.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const quint32 pixel = random.generate();
+        quint32 other = random.generate() & 0xff000000u;
+        for (int shift = 0; shift < 24; shift += 8) {
+            const int channel = int((pixel >> shift) & 0xff);
+            const int delta = int(random.bounded(2 * maxDelta + 1)) - maxDelta;
+            other |= quint32(qBound(0, channel + delta, 255)) << shift;
+        }
+        a[i] = pixel;
+        b[i] = other;
+    }
+}
+
+void PixelKernelsTest::countSimilarMatchesScalar_data()
+{
+    QTest::addColumn<QString>("implementation");
+    for (const QString& name : PixelKernels::availableImplementations()) {
+        QTest::newRow(qPrintable(name)) << name;
+    }
+}
+
+void PixelKernelsTest::countSimilarMatchesScalar()
+{
+    QFETCH(QString, implementation);
+    QRandomGenerator random(20240602);
+    QVector<quint32> a;
+    QVector<quint32> b;
+
+    // 0~67 覆盖 AVX2（8 像素）与 SSE4.1（4 像素）的所有尾部长度，另加几个较长的行
+    QList<int> lengths;
+    for (int count = 0; count <= 67; ++count) {
+        lengths.append(count);
+    }
+    lengths << 1000 << 1001 << 1923 << 2560;
+
+    for (int count : lengths) {
+        // maxDelta 为 255 时出现单通道差值饱和的极端情况
+        for (int maxDelta : {4, 40, 255}) {
+            makeRows(random, count, maxDelta, a, b);
+            for (int threshold : {0, 1, 30, 100, 766}) {
+                const int expected = PixelKernels::countSimilarPixels(QStringLiteral("scalar"), a.constData(), b.constData(), count, threshold);
+                const int actual = PixelKernels::countSimilarPixels(implementation, a.constData(), b.constData(), count, threshold);
+                if (actual != expected) {
+                    QFAIL(qPrintable(QString("长度 %1、最大偏移 %2、阈值 %3：%4 得到 %5，标量为 %6")
+                                         .arg(count).arg(maxDelta).arg(threshold).arg(implementation).arg(actual).arg(expected)));
+                }
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(PixelKernelsTest)
+#include "pixelkernelstest.moc"
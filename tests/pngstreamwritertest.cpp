@@ -0,0 +1,112 @@
+#include "pngstreamwriter.h"
+#include <QBuffer>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QtTest>
+#include <cstring>
+
+// 流式 PNG 编码的往返测试：同一幅图像分别逐行写出和按条带并行写出，
+// 两份结果用 QImage 解码后必须与原图逐像素一致
+class PngStreamWriterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void sequentialAndParallelMatch_data();
+    void sequentialAndParallelMatch();
+
+private:
+    static QImage makeCanvas(int width, int height);
+    static QByteArray encode(const QImage& image, bool parallel);
+};
+
+void PngStreamWriterTest::initTestCase()
+{
+    // 单核机器上也要走并行路径
+    if (QThreadPool::globalInstance()->maxThreadCount() < 2) {
+        QThreadPool::globalInstance()->setMaxThreadCount(4);
+    }
+}
+
+// 渐变叠加随机噪声和重复的横条：既有可压缩的长匹配（条带之间依赖预设字典），
+// 也有难以压缩的区域，覆盖各种过滤类型
+QImage PngStreamWriterTest::makeCanvas(int width, int height)
+{
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    QRandomGenerator random(20240601);
+    for (int y = 0; y < height; ++y) {
+        QRgb* row = reinterpret_cast<QRgb*>(image.scanLine(y));
+        const bool stripe = (y / 16) % 5 == 0;
+        for (int x = 0; x < width; ++x) {
+            if (stripe) {
+                row[x] = qRgb(x % 256, 200, 40);
+            } else {
+                const int noise = int(random.bounded(32));
+                row[x] = qRgb((x + noise) % 256, (y / 4) % 256, (x ^ y) & 0xff);
+            }
+        }
+    }
+    return image;
+}
+
+QByteArray PngStreamWriterTest::encode(const QImage& image, bool parallel)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    PngStreamWriter writer(&buffer);
+    writer.setParallelEnabled(parallel);
+    const bool ok = writer.writeImage(image.width(), image.height(), [&image](int y, uchar* argbRow) {
+        std::memcpy(argbRow, image.constScanLine(y), size_t(image.width()) * 4);
+    });
+    if (!ok) {
+        qWarning() << "PNG 写出失败:" << writer.errorString();
+        return QByteArray();
+    }
+    return buffer.data();
+}
+
+void PngStreamWriterTest::sequentialAndParallelMatch_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+
+    // 高度都超过一个条带；最后一个条带不满
+    QTest::newRow("narrow") << 320 << 4000;
+    QTest::newRow("wide") << 1500 << 2100;
+}
+
+void PngStreamWriterTest::sequentialAndParallelMatch()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+
+    const QImage source = makeCanvas(width, height);
+    const QByteArray sequentialPng = encode(source, false);
+    const QByteArray parallelPng = encode(source, true);
+    QVERIFY(!sequentialPng.isEmpty());
+    QVERIFY(!parallelPng.isEmpty());
+
+    QImage sequential;
+    QImage parallel;
+    QVERIFY(sequential.loadFromData(sequentialPng, "PNG"));
+    QVERIFY(parallel.loadFromData(parallelPng, "PNG"));
+    QCOMPARE(sequential.size(), source.size());
+    QCOMPARE(parallel.size(), source.size());
+
+    const QImage expected = source.convertToFormat(QImage::Format_ARGB32);
+    sequential = sequential.convertToFormat(QImage::Format_ARGB32);
+    parallel = parallel.convertToFormat(QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        if (std::memcmp(sequential.constScanLine(y), expected.constScanLine(y), size_t(width) * 4) != 0) {
+            QFAIL(qPrintable(QString("逐行写出的第 %1 行与原图不一致").arg(y)));
+        }
+        if (std::memcmp(parallel.constScanLine(y), sequential.constScanLine(y), size_t(width) * 4) != 0) {
+            QFAIL(qPrintable(QString("并行写出的第 %1 行与逐行写出不一致").arg(y)));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(PngStreamWriterTest)
+#include "pngstreamwritertest.moc"
@@ -0,0 +1,237 @@
+#include "x11shmcapturebackend.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QDebug>
+#include <atomic>
+#include <cstdlib>
+#include <xcb/xcb.h>
+#include <xcb/shm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+const int X11ShmCaptureBackend::MAX_SEGMENTS;
+
+// 共享内存段：后端自身持有一个引用，每个交出去的 QImage 再持有一个引用
+struct X11ShmSegment {
+    std::atomic<int> refs{1};
+    xcb_shm_seg_t seg = 0;
+    int shmId = -1;
+    uchar* data = nullptr;
+    size_t size = 0;
+};
+
+// QImage 的清理回调：最后一个引用释放时才解除本进程的映射
+static void releaseShmSegment(void* info)
+{
+    X11ShmSegment* segment = static_cast<X11ShmSegment*>(info);
+    if (segment->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (segment->data) {
+            shmdt(segment->data);
+        }
+        delete segment;
+    }
+}
+
+X11ShmCaptureBackend::X11ShmCaptureBackend()
+{
+    m_available = connectToServer();
+}
+
+X11ShmCaptureBackend::~X11ShmCaptureBackend()
+{
+    releaseSegments();
+    if (m_connection) {
+        xcb_disconnect(m_connection);
+    }
+}
+
+bool X11ShmCaptureBackend::connectToServer()
+{
+    if (QGuiApplication::platformName() != QLatin1String("xcb")) {
+        return false;
+    }
+
+    // 使用独立连接，抓取可以在任意线程进行而不干扰 Qt 自身的 xcb 连接
+    int screenNumber = 0;
+    m_connection = xcb_connect(nullptr, &screenNumber);
+    if (!m_connection || xcb_connection_has_error(m_connection)) {
+        qDebug() << "❌ 无法连接 X 服务器";
+        return false;
+    }
+
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(m_connection, &xcb_shm_id);
+    if (!ext || !ext->present) {
+        qDebug() << "X 服务器不支持 MIT-SHM 扩展";
+        return false;
+    }
+    xcb_shm_query_version_reply_t* version =
+        xcb_shm_query_version_reply(m_connection, xcb_shm_query_version(m_connection), nullptr);
+    if (!version) {
+        return false;
+    }
+    free(version);
+
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(m_connection));
+    for (int i = 0; i < screenNumber && it.rem; ++i) {
+        xcb_screen_next(&it);
+    }
+    if (!it.rem) {
+        return false;
+    }
+    m_root = it.data->root;
+    return true;
+}
+
+bool X11ShmCaptureBackend::prepare(QScreen* screen, const QRect& logicalRect)
+{
+    if (!m_available || !CaptureBackend::prepare(screen, logicalRect)) {
+        return false;
+    }
+
+    const size_t size = size_t(m_deviceRect.width()) * m_deviceRect.height() * 4;
+    if (size != m_segmentSize) {
+        // 选区尺寸变化，按新尺寸重新分配共享内存段
+        releaseSegments();
+        m_segmentSize = size;
+    }
+    if (m_segments.isEmpty()) {
+        X11ShmSegment* segment = createSegment();
+        if (!segment) {
+            return false;
+        }
+        m_segments.append(segment);
+    }
+    return true;
+}
+
+X11ShmSegment* X11ShmCaptureBackend::createSegment()
+{
+    X11ShmSegment* segment = new X11ShmSegment;
+    segment->size = m_segmentSize;
+    segment->shmId = shmget(IPC_PRIVATE, m_segmentSize, IPC_CREAT | 0600);
+    if (segment->shmId < 0) {
+        qDebug() << "❌ shmget 失败，大小:" << m_segmentSize;
+        delete segment;
+        return nullptr;
+    }
+    void* address = shmat(segment->shmId, nullptr, 0);
+    if (address == reinterpret_cast<void*>(-1)) {
+        shmctl(segment->shmId, IPC_RMID, nullptr);
+        delete segment;
+        return nullptr;
+    }
+    segment->data = static_cast<uchar*>(address);
+
+    segment->seg = xcb_generate_id(m_connection);
+    xcb_generic_error_t* error =
+        xcb_request_check(m_connection, xcb_shm_attach_checked(m_connection, segment->seg, segment->shmId, 0));
+    // 服务器已附加（或失败），标记删除：所有进程解除映射后由内核回收
+    shmctl(segment->shmId, IPC_RMID, nullptr);
+    if (error) {
+        qDebug() << "❌ xcb_shm_attach 失败，错误码:" << error->error_code;
+        free(error);
+        shmdt(segment->data);
+        delete segment;
+        return nullptr;
+    }
+    return segment;
+}
+
+X11ShmSegment* X11ShmCaptureBackend::acquireSegment()
+{
+    // 只有后端自己持有引用的段才能被覆盖写入
+    for (X11ShmSegment* segment : m_segments) {
+        if (segment->refs.load(std::memory_order_acquire) == 1) {
+            return segment;
+        }
+    }
+    if (m_segments.size() < MAX_SEGMENTS) {
+        X11ShmSegment* segment = createSegment();
+        if (segment) {
+            m_segments.append(segment);
+            return segment;
+        }
+    }
+    return nullptr;
+}
+
+void X11ShmCaptureBackend::releaseSegments()
+{
+    QList<X11ShmSegment*> all = m_segments;
+    if (m_overflow) {
+        all.append(m_overflow);
+    }
+    for (X11ShmSegment* segment : all) {
+        if (m_connection) {
+            xcb_shm_detach(m_connection, segment->seg);
+        }
+        releaseShmSegment(segment);
+    }
+    if (m_connection) {
+        xcb_flush(m_connection);
+    }
+    m_segments.clear();
+    m_overflow = nullptr;
+}
+
+QImage X11ShmCaptureBackend::grabFrame()
+{
+    if (!m_connection || m_deviceRect.isEmpty()) {
+        return QImage();
+    }
+
+    bool overflow = false;
+    X11ShmSegment* segment = acquireSegment();
+    if (!segment) {
+        // 调用方持有的帧过多，抓到备用段后深拷贝返回
+        if (!m_overflow) {
+            m_overflow = createSegment();
+        }
+        segment = m_overflow;
+        overflow = true;
+    }
+    if (!segment) {
+        return QImage();
+    }
+
+    xcb_shm_get_image_cookie_t cookie = xcb_shm_get_image(
+        m_connection, m_root,
+        static_cast<int16_t>(m_deviceRect.x()), static_cast<int16_t>(m_deviceRect.y()),
+        static_cast<uint16_t>(m_deviceRect.width()), static_cast<uint16_t>(m_deviceRect.height()),
+        ~0u, XCB_IMAGE_FORMAT_Z_PIXMAP, segment->seg, 0);
+    xcb_generic_error_t* error = nullptr;
+    xcb_shm_get_image_reply_t* reply = xcb_shm_get_image_reply(m_connection, cookie, &error);
+    if (error || !reply) {
+        qDebug() << "❌ xcb_shm_get_image 失败" << (error ? int(error->error_code) : -1);
+        free(error);
+        free(reply);
+        return QImage();
+    }
+    const int depth = reply->depth;
+    free(reply);
+    if (depth != 24 && depth != 32) {
+        qDebug() << "❌ 不支持的 X 视觉深度:" << depth;
+        return QImage();
+    }
+
+    // 24/32 位 ZPixmap 在小端机器上即 BGRX，对应 QImage::Format_RGB32。
+    // 深度 24 时填充字节通常为 0x00，而 Qt 约定 RGB32 为 0xffRRGGBB，下游直接按预乘 ARGB 拷贝像素，这里统一补齐
+    const int width = m_deviceRect.width();
+    const int height = m_deviceRect.height();
+    quint32* pixels = reinterpret_cast<quint32*>(segment->data);
+    const qint64 pixelCount = qint64(width) * height;
+    for (qint64 i = 0; i < pixelCount; ++i) {
+        pixels[i] |= 0xff000000u;
+    }
+    if (overflow) {
+        QImage copy = QImage(segment->data, width, height, width * 4, QImage::Format_RGB32).copy();
+        copy.setDevicePixelRatio(m_screen->devicePixelRatio());
+        return copy;
+    }
+
+    segment->refs.fetch_add(1, std::memory_order_acq_rel);
+    QImage frame(segment->data, width, height, width * 4, QImage::Format_RGB32,
+                 releaseShmSegment, segment);
+    frame.setDevicePixelRatio(m_screen->devicePixelRatio());
+    return frame;
+}
@@ -0,0 +1,46 @@
+#ifndef X11SHMCAPTUREBACKEND_H
+#define X11SHMCAPTUREBACKEND_H
+
+#include "capturebackend.h"
+#include <QList>
+
+struct xcb_connection_t;
+struct X11ShmSegment;
+
+// 基于 XCB MIT-SHM 的零拷贝截图后端（Linux/X11）
+// X 服务器直接把选区像素写入共享内存段，返回的 QImage 直接引用该内存，不做拷贝。
+// 共享内存段按选区尺寸分配并在多帧之间复用：只有当上一帧的 QImage 仍被持有时才会启用下一个段，
+// 因此调用方可以像普通 QImage 一样长期持有返回的帧。
+class X11ShmCaptureBackend : public CaptureBackend
+{
+public:
+    X11ShmCaptureBackend();
+    ~X11ShmCaptureBackend() override;
+
+    QString name() const override { return QStringLiteral("x11-shm"); }
+    bool prepare(QScreen* screen, const QRect& logicalRect) override;
+
+    // 当前会话是否为 X11 且服务器支持 MIT-SHM
+    bool isAvailable() const { return m_available; }
+
+protected:
+    QImage grabFrame() override;
+
+private:
+    bool connectToServer();
+    X11ShmSegment* createSegment();
+    X11ShmSegment* acquireSegment();
+    void releaseSegments();
+
+    xcb_connection_t* m_connection = nullptr;
+    quint32 m_root = 0;
+    bool m_available = false;
+
+    QList<X11ShmSegment*> m_segments;       // 可交给调用方的段（按需增长）
+    X11ShmSegment* m_overflow = nullptr;    // 所有段都被占用时使用，结果会深拷贝
+    size_t m_segmentSize = 0;
+
+    static const int MAX_SEGMENTS = 8;      // 同时在外持有的帧数上限
+};
+
+#endif // X11SHMCAPTUREBACKEND_H